@@ -0,0 +1,114 @@
+// rechor project
+// bench_import.cpp
+//
+// FBXImporter::load on a sample scene, serial reference vs threaded: time per
+// run and whether the baked mesh/bone tracks match the serial ones bit for bit
+// (needs the FBX SDK, unlike the other benches)
+// usage: bench_import <scene.fbx> [--threads N] [--iters N]
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include "rechor/fbx_importer.hpp"
+#include "parallel.hpp"
+
+using namespace rhakt;
+using namespace rhakt::rechor;
+
+namespace {
+
+    // best of iters [ms], scene of the last run
+    double measure(const char* filename, uint threads, std::size_t iters, Scene& scene) {
+        auto best = 1e30;
+        for(std::size_t i = 0; i < iters; i++) {
+            // a fresh importer each run: FBXImporter keeps the raw scenes it loaded
+            FBXImporter importer;
+            importer.setThreads(threads);
+            Scene s;
+            const auto begin = std::chrono::high_resolution_clock::now();
+            if(!importer.load(filename, s)) { return -1.0; }
+            const auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - begin).count());
+            scene = std::move(s);
+        }
+        return best;
+    }
+
+    // first differing track as "anim a mesh m bones", empty when all match
+    std::string compareTracks(const Scene& a, const Scene& b) {
+        if(a.animes.size() != b.animes.size()) { return "anim count"; }
+        for(std::size_t i = 0; i < a.animes.size(); i++) {
+            const auto& x = a.animes[i].meshes;
+            const auto& y = b.animes[i].meshes;
+            if(x.size() != y.size()) { return "anim " + std::to_string(i) + " mesh count"; }
+            for(std::size_t m = 0; m < x.size(); m++) {
+                const auto where = "anim " + std::to_string(i) + " mesh " + std::to_string(m);
+                const auto& xm = x[m].meshMatrices;
+                const auto& ym = y[m].meshMatrices;
+                if(xm.frameCount != ym.frameCount || xm.stride != ym.stride || xm.data != ym.data) { return where + " meshMatrices"; }
+                const auto& xb = x[m].boneMatrices;
+                const auto& yb = y[m].boneMatrices;
+                if(xb.frameCount != yb.frameCount || xb.stride != yb.stride || xb.data != yb.data) { return where + " boneMatrices"; }
+            }
+        }
+        return std::string();
+    }
+
+} // namespace
+
+auto main(int argc, char* argv[])-> int {
+
+    if(argc < 2 || argv[1][0] == '-') {
+        std::cerr << "usage: bench_import <scene.fbx> [--threads N] [--iters N]" << std::endl;
+        return -1;
+    }
+    const char* const filename = argv[1];
+    std::size_t iters = 3;
+    uint threads = 0;
+    for(int i = 2; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        const auto value = std::strtod(argv[i + 1], nullptr);
+        if(arg == "--iters") { iters = std::max<std::size_t>(1, static_cast<std::size_t>(value)); }
+        else if(arg == "--threads") { threads = static_cast<uint>(value); }
+        else {
+            std::cerr << "unknown option " << arg << std::endl;
+            return -1;
+        }
+    }
+    logger::setLevel(LOGLEVEL::WARN);
+
+    Scene serial, threaded;
+    const auto ts = measure(filename, 1, iters, serial);
+    const auto tt = measure(filename, threads, iters, threaded);
+    if(ts < 0.0 || tt < 0.0) {
+        logger::flush();
+        std::cerr << "fail to load " << filename << std::endl;
+        return -1;
+    }
+
+    std::size_t frames = 0, bones = 0;
+    for(auto&& a : serial.animes) {
+        for(auto&& m : a.meshes) {
+            frames = std::max<std::size_t>(frames, std::max(m.meshMatrices.frameCount, m.boneMatrices.frameCount));
+            bones += m.boneMatrices.stride / 16;
+        }
+    }
+    std::cout << filename << ": " << serial.meshes.size() << " meshes, " << bones << " bones, " << frames << " frames, threads: "
+              << util::resolve_threads(threads) << std::endl;
+    std::cout << std::left << std::setw(12) << "load" << std::right << std::setw(12) << "ms" << std::setw(10) << "speedup" << std::endl;
+    std::cout << std::left << std::setw(12) << "serial" << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << ts << std::setw(10) << std::setprecision(1) << 1.0 << std::endl;
+    std::cout << std::left << std::setw(12) << "threaded" << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << tt << std::setw(10) << std::setprecision(1) << ts / tt << std::endl;
+
+    const auto diff = compareTracks(serial, threaded);
+    if(!diff.empty()) {
+        std::cerr << "anim track mismatch: " << diff << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,352 @@
+// rechor project
+// bench_pipeline.cpp
+//
+// welding, bounds, meshlets, Exporter::save, Importer::load, clip sampling and LZ4 on synthetic scenes (no FBX SDK)
+// usage: bench_pipeline [--meshes N] [--vertices N] [--bones N] [--frames N]
+//                       [--dup RATIO] [--instances N] [--iters N] [--threads N]
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <new>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "rechor/vertex_welder.hpp"
+#include "rechor/rechor_exporter.hpp"
+#include "rechor/rechor_importer.hpp"
+#include "rechor/anim_sampler.hpp"
+#include "rechor/meshlet.hpp"
+
+/*-- allocation counting --*/
+
+namespace {
+    std::atomic<std::size_t> allocCount(0);
+    std::atomic<std::size_t> allocBytes(0);
+
+    void* allocate(std::size_t size) {
+        allocCount++;
+        allocBytes += size;
+        if(void* p = std::malloc(size ? size : 1)) { return p; }
+        throw std::bad_alloc();
+    }
+
+    void release(void* p) noexcept { std::free(p); }
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, std::size_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t) noexcept { release(p); }
+
+using namespace rhakt::rechor;
+
+namespace {
+
+    struct SceneParams {
+        std::size_t meshes = 4;
+        std::size_t vertices = 50000;   // unique vertices per mesh
+        std::size_t bones = 64;
+        std::size_t frames = 120;
+        double duplicate = 0.8;         // share of polygon vertices that repeat an earlier one
+    };
+
+    // unrolled polygon vertices, the shape of MeshRaw without the FBX parts
+    struct RawMesh {
+        std::vector<uint> indices;
+        std::vector<vertex_t> vertices;
+        std::vector<normal_t> normals;
+        std::vector<color_t> colors;
+        std::vector<uv_t> uvs;
+        std::vector<bindex_t> boneIndices;
+        std::vector<bweight_t> boneWeights;
+
+        std::size_t bytes() const {
+            return indices.size() * (sizeof(uint) + sizeof(vertex_t) + sizeof(normal_t) + sizeof(uv_t))
+                + colors.size() * sizeof(color_t) + boneIndices.size() * sizeof(bindex_t) + boneWeights.size() * sizeof(bweight_t);
+        }
+    };
+
+    RawMesh makeRaw(const SceneParams& p, std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(-1.f, 1.f);
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+        const auto dup = std::min(std::max(p.duplicate, 0.0), 0.95);
+        const auto corners = (static_cast<std::size_t>(p.vertices / (1.0 - dup)) + 2) / 3 * 3;
+        const auto bones = static_cast<uint>(std::max<std::size_t>(p.bones, 1));
+
+        RawMesh raw;
+        raw.indices.reserve(corners);
+        std::vector<uint> corner;
+        corner.reserve(corners);
+        std::size_t created = 0;
+        for(std::size_t c = 0; c < corners; c++) {
+            const auto fresh = created < p.vertices && (created == 0 || corners - c <= p.vertices - created || chance(rng) >= dup);
+            if(fresh) {
+                corner.push_back(static_cast<uint>(created++));
+            } else {
+                // reuse a recent vertex, like neighbouring polygons do
+                const auto window = std::min<std::size_t>(created, 64);
+                corner.push_back(static_cast<uint>(created - 1 - rng() % window));
+            }
+        }
+
+        /* attributes of every unique vertex, then unrolled per corner */
+        std::vector<element_t> unique(created);
+        for(std::size_t v = 0; v < created; v++) {
+            vertex_t pos = {{ unit(rng), unit(rng), unit(rng) }};
+            const auto len = std::sqrt(pos[0] * pos[0] + pos[1] * pos[1] + pos[2] * pos[2]) + 1e-6f;
+            const auto b = static_cast<uint>(v * bones / std::max<std::size_t>(created, 1));
+            const auto w = 0.5f + 0.5f * std::fabs(unit(rng));
+            unique[v] = std::make_tuple(
+                pos,
+                normal_t{{ pos[0] / len, pos[1] / len, pos[2] / len }},
+                color_t{{ 1.f, 1.f, 1.f, 1.f }},
+                uv_t{{ 0.5f + 0.5f * unit(rng), 0.5f + 0.5f * unit(rng) }},
+                bindex_t{{ b, (b + 1) % bones, 0U, 0U }},
+                bweight_t{{ w, 1.f - w, 0.f, 0.f }}
+            );
+        }
+        for(auto&& c : corner) {
+            const auto& e = unique[c];
+            raw.indices.push_back(static_cast<uint>(raw.indices.size()));
+            raw.vertices.push_back(std::get<0>(e));
+            raw.normals.push_back(std::get<1>(e));
+            raw.colors.push_back(std::get<2>(e));
+            raw.uvs.push_back(std::get<3>(e));
+            raw.boneIndices.push_back(std::get<4>(e));
+            raw.boneWeights.push_back(std::get<5>(e));
+        }
+        return raw;
+    }
+
+    // smooth rotations about y with a little translation, row vectors like FBX
+    void makeMatrix(float angle, float tx, float ty, float tz, float* m) {
+        const auto c = std::cos(angle), s = std::sin(angle);
+        const float r[16] = {
+            c, 0.f, -s, 0.f,
+            0.f, 1.f, 0.f, 0.f,
+            s, 0.f, c, 0.f,
+            tx, ty, tz, 1.f
+        };
+        std::memcpy(m, r, sizeof(r));
+    }
+
+    Anim makeAnim(const SceneParams& p) {
+        Anim anim;
+        for(std::size_t m = 0; m < p.meshes; m++) {
+            Track mm, bm;
+            mm.resize(static_cast<uint>(p.frames), 16);
+            bm.resize(static_cast<uint>(p.frames), static_cast<uint>(p.bones * 16));
+            for(std::size_t f = 0; f < p.frames; f++) {
+                const auto t = static_cast<float>(f) / 30.f;
+                makeMatrix(0.f, 0.f, 0.f, t * 0.1f, mm.frame(f));
+                for(std::size_t b = 0; b < p.bones; b++) {
+                    makeMatrix(std::sin(t * 2.f + b * 0.3f) * 0.5f, 0.f, b * 0.05f, 0.f, bm.frame(f) + b * 16);
+                }
+            }
+            anim.meshes.emplace_back(std::move(mm), std::move(bm));
+        }
+        return anim;
+    }
+
+    /*-- measurement --*/
+
+    std::size_t peakRSS() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS pmc;
+        return ::GetProcessMemoryInfo(::GetCurrentProcess(), &pmc, sizeof(pmc)) ? pmc.PeakWorkingSetSize : 0;
+#else
+        struct rusage ru;
+        ::getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+        return static_cast<std::size_t>(ru.ru_maxrss);
+#else
+        return static_cast<std::size_t>(ru.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+
+    struct Sample {
+        double ms;          // best of all iterations
+        std::size_t allocs; // per iteration
+        std::size_t bytes;
+    };
+
+    template <typename F>
+    Sample measure(std::size_t iters, F&& f) {
+        Sample s = { 1e300, 0, 0 };
+        for(std::size_t i = 0; i < iters; i++) {
+            const auto c0 = allocCount.load(), b0 = allocBytes.load();
+            const auto begin = std::chrono::high_resolution_clock::now();
+            f();
+            const auto end = std::chrono::high_resolution_clock::now();
+            s.ms = std::min(s.ms, std::chrono::duration<double, std::milli>(end - begin).count());
+            s.allocs = allocCount.load() - c0;
+            s.bytes = allocBytes.load() - b0;
+        }
+        return s;
+    }
+
+    void report(const char* name, std::size_t dataBytes, const Sample& s) {
+        const auto mb = 1024.0 * 1024.0;
+        std::cout << std::left << std::setw(18) << name << std::right << std::fixed
+                  << std::setw(10) << std::setprecision(2) << dataBytes / mb
+                  << std::setw(12) << s.ms
+                  << std::setw(12) << std::setprecision(1) << (s.ms > 0.0 ? dataBytes / mb / (s.ms / 1000.0) : 0.0)
+                  << std::setw(12) << s.allocs
+                  << std::setw(12) << std::setprecision(2) << s.bytes / mb
+                  << std::setw(12) << peakRSS() / mb << std::endl;
+    }
+
+    std::size_t filesize(const char* name) {
+        std::string buf;
+        return rhakt::util::loadfile(name, true, buf) ? buf.size() : 0;
+    }
+
+} // namespace
+
+auto main(int argc, char* argv[])-> int {
+
+    SceneParams params;
+    std::size_t iters = 5;
+    std::size_t instances = 1000;
+    uint threads = 1;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        const auto value = std::strtod(argv[i + 1], nullptr);
+        if(arg == "--meshes") { params.meshes = static_cast<std::size_t>(value); }
+        else if(arg == "--vertices") { params.vertices = static_cast<std::size_t>(value); }
+        else if(arg == "--bones") { params.bones = static_cast<std::size_t>(value); }
+        else if(arg == "--frames") { params.frames = static_cast<std::size_t>(value); }
+        else if(arg == "--dup") { params.duplicate = value; }
+        else if(arg == "--instances") { instances = static_cast<std::size_t>(value); }
+        else if(arg == "--iters") { iters = std::max<std::size_t>(1, static_cast<std::size_t>(value)); }
+        else if(arg == "--threads") { threads = static_cast<uint>(value); }
+        else {
+            std::cerr << "unknown option " << arg << std::endl;
+            return -1;
+        }
+    }
+    rhakt::logger::setLevel(rhakt::LOGLEVEL::ERR);
+
+    std::vector<RawMesh> raws;
+    std::size_t rawBytes = 0;
+    for(std::size_t m = 0; m < params.meshes; m++) {
+        raws.push_back(makeRaw(params, static_cast<std::uint32_t>(1234 + m)));
+        rawBytes += raws.back().bytes();
+    }
+
+    std::cout << params.meshes << " meshes x " << params.vertices << " vertices (" << raws[0].indices.size() / 3 << " triangles, "
+              << params.duplicate << " duplicate), " << params.bones << " bones x " << params.frames << " frames" << std::endl;
+    std::cout << std::left << std::setw(18) << "stage" << std::right
+              << std::setw(10) << "MB"
+              << std::setw(12) << "ms"
+              << std::setw(12) << "MB/s"
+              << std::setw(12) << "allocs"
+              << std::setw(12) << "alloc MB"
+              << std::setw(12) << "peak RSS" << std::endl;
+
+    Scene scene;
+    report("weld", rawBytes, measure(iters, [&]{
+        scene.meshes.clear();
+        for(auto&& r : raws) { scene.meshes.push_back(weldMesh(r)); }
+    }));
+    scene.animes.push_back(makeAnim(params));
+
+    // bind pose and per frame boxes (every frame skinned), kept in the scene for the saves below
+    std::size_t skinnedBytes = 0;
+    for(auto&& m : scene.meshes) { skinnedBytes += m.vertices.size() * sizeof(float) * params.frames; }
+    report("bounds", skinnedBytes, measure(iters, [&]{ bounds::computeBounds(scene, threads); }));
+
+    // on copies, so the saves below are unchanged
+    std::vector<Mesh> clustered(scene.meshes);
+    std::size_t indexBytes = 0;
+    for(auto&& m : clustered) { indexBytes += m.indices.size() * sizeof(int); }
+    report("meshlets", indexBytes, measure(iters, [&]{
+        rhakt::util::parallel_for(clustered.size(), threads, [&](std::size_t i) { buildMeshlets(clustered[i]); });
+    }));
+
+    const char* const plain = "bench_pipeline_plain.rkr";
+    const char* const packed = "bench_pipeline_lz4.rkr";
+    Exporter exporter;
+    exporter.setThreads(threads);
+    exporter.setBounds(false);
+
+    exporter.setCodec(CODEC::NONE);
+    auto s = measure(iters, [&]{ exporter.save(plain, scene); });
+    const auto sceneBytes = filesize(plain);
+    report("save (none)", sceneBytes, s);
+
+    exporter.setCodec(CODEC::LZ4);
+    s = measure(iters, [&]{ exporter.save(packed, scene); });
+    report("save (lz4)", sceneBytes, s);
+
+    Importer importer;
+    Scene loaded;
+    report("load (none)", sceneBytes, measure(iters, [&]{ loaded = Scene(); importer.load(plain, loaded); }));
+    report("load (lz4)", sceneBytes, measure(iters, [&]{ loaded = Scene(); importer.load(packed, loaded); }));
+
+    // same loads into one arena, rewound (not freed) between iterations
+    rhakt::util::Arena arena;
+    auto arenaLoad = [&](const char* filename) {
+        {
+            ArenaScene a(arena);
+            importer.load(filename, a);
+        }
+        arena.reset();
+    };
+    report("load arena (none)", sceneBytes, measure(iters, [&]{ arenaLoad(plain); }));
+    report("load arena (lz4)", sceneBytes, measure(iters, [&]{ arenaLoad(packed); }));
+
+    // one palette per instance of mesh 0, each at its own time
+    if(params.bones > 0) {
+        std::vector<float> times(instances);
+        for(std::size_t i = 0; i < instances; i++) { times[i] = 0.0137f * i; }
+        std::vector<float> palettes(instances * params.bones * 16);
+        const auto paletteBytes = palettes.size() * sizeof(float);
+        AnimSampler sampler(loaded.animes[0]);
+        sampler.setThreads(threads);
+        report("sample lerp", paletteBytes, measure(iters, [&]{ sampler.sample(0, times.data(), instances, palettes.data()); }));
+        sampler.setMode(SAMPLE_MODE::SLERP);
+        report("sample slerp", paletteBytes, measure(iters, [&]{ sampler.sample(0, times.data(), instances, palettes.data()); }));
+    }
+
+    /* the codec alone, on the plain flatbuffer */
+    std::string src;
+    rhakt::util::loadfile(plain, true, src);
+    std::vector<char> dst(LZ4_compressBound(static_cast<int>(src.size())));
+    std::vector<char> back(src.size());
+    int compressed = 0;
+    report("lz4 compress", src.size(), measure(iters, [&]{
+        compressed = LZ4_compress_default(src.data(), dst.data(), static_cast<int>(src.size()), static_cast<int>(dst.size()));
+    }));
+    report("lz4 decompress", src.size(), measure(iters, [&]{
+        LZ4_decompress_safe(dst.data(), back.data(), compressed, static_cast<int>(back.size()));
+    }));
+    if(std::memcmp(src.data(), back.data(), src.size()) != 0) {
+        std::cerr << "lz4 roundtrip mismatch" << std::endl;
+        return -1;
+    }
+    std::cout << "lz4 ratio " << std::setprecision(3) << static_cast<double>(compressed) / src.size()
+              << ", file " << filesize(packed) << " bytes" << std::endl;
+
+    std::remove(plain);
+    std::remove(packed);
+}
@@ -0,0 +1,149 @@
+// rechor project
+// bench_skinning.cpp
+//
+// CPU skinning throughput: scalar reference vs SIMD kernel, single and multithreaded
+// usage: bench_skinning [--vertices N] [--bones N] [--iters N] [--threads N]
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include "rechor/skinning.hpp"
+
+using namespace rhakt::rechor;
+
+namespace {
+
+    // random points with 4 influences each, weights summing to 1
+    Mesh makeMesh(std::size_t vertices, std::size_t bones, std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(-1.f, 1.f);
+        std::uniform_int_distribution<int> bone(0, static_cast<int>(bones) - 1);
+
+        Mesh mesh;
+        mesh.vertices.reserve(vertices * 3);
+        mesh.normals.reserve(vertices * 3);
+        mesh.boneIndices.reserve(vertices * 4);
+        mesh.boneWeights.reserve(vertices * 4);
+        for(std::size_t v = 0; v < vertices; v++) {
+            float p[3] = { unit(rng), unit(rng), unit(rng) };
+            const auto len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]) + 1e-6f;
+            float w[4], total = 0.f;
+            for(int k = 0; k < 4; k++) { total += w[k] = std::fabs(unit(rng)) + 0.01f; }
+            for(int k = 0; k < 3; k++) {
+                mesh.vertices.push_back(p[k]);
+                mesh.normals.push_back(p[k] / len);
+            }
+            for(int k = 0; k < 4; k++) {
+                mesh.boneIndices.push_back(bone(rng));
+                mesh.boneWeights.push_back(w[k] / total);
+            }
+        }
+        return mesh;
+    }
+
+    // rotations about y with a translation, row vectors like FBX
+    std::vector<float> makePalette(std::size_t bones) {
+        std::vector<float> palette(bones * 16);
+        for(std::size_t b = 0; b < bones; b++) {
+            const auto a = 0.1f * b, c = std::cos(a), s = std::sin(a);
+            const float m[16] = {
+                c, 0.f, -s, 0.f,
+                0.f, 1.f, 0.f, 0.f,
+                s, 0.f, c, 0.f,
+                0.01f * b, 0.02f * b, 0.f, 1.f
+            };
+            std::copy(m, m + 16, &palette[b * 16]);
+        }
+        return palette;
+    }
+
+    // best of iters [ms]
+    template <typename F>
+    double measure(std::size_t iters, F&& f) {
+        auto best = 1e30;
+        for(std::size_t i = 0; i < iters; i++) {
+            const auto begin = std::chrono::high_resolution_clock::now();
+            f();
+            const auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - begin).count());
+        }
+        return best;
+    }
+
+    double maxDiff(const std::vector<float>& a, const std::vector<float>& b) {
+        double d = 0.0;
+        for(std::size_t i = 0; i < a.size(); i++) { d = std::max(d, static_cast<double>(std::fabs(a[i] - b[i]))); }
+        return d;
+    }
+
+} // namespace
+
+auto main(int argc, char* argv[])-> int {
+
+    std::size_t vertices = 1000000;
+    std::size_t bones = 64;
+    std::size_t iters = 5;
+    uint threads = 0;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        const auto value = std::strtod(argv[i + 1], nullptr);
+        if(arg == "--vertices") { vertices = std::max<std::size_t>(1, static_cast<std::size_t>(value)); }
+        else if(arg == "--bones") { bones = std::max<std::size_t>(1, static_cast<std::size_t>(value)); }
+        else if(arg == "--iters") { iters = std::max<std::size_t>(1, static_cast<std::size_t>(value)); }
+        else if(arg == "--threads") { threads = static_cast<uint>(value); }
+        else {
+            std::cerr << "unknown option " << arg << std::endl;
+            return -1;
+        }
+    }
+
+    const auto mesh = makeMesh(vertices, bones, 1234);
+    const auto palette = makePalette(bones);
+    std::vector<float> refPositions(mesh.vertices.size()), refNormals(mesh.normals.size());
+    std::vector<float> positions(mesh.vertices.size()), normals(mesh.normals.size());
+    const skinning::Job ref = {
+        mesh.vertices.data(), mesh.normals.data(), mesh.boneIndices.data(), mesh.boneWeights.data(),
+        palette.data(), bones, refPositions.data(), refNormals.data()
+    };
+
+#if defined(RECHOR_SKINNING_AVX)
+    const char* const simd = "avx";
+#elif defined(RECHOR_SKINNING_SSE2)
+    const char* const simd = "sse2";
+#else
+    const char* const simd = "scalar fallback";
+#endif
+    std::cout << vertices << " vertices x 4 influences, " << bones << " bones, simd: " << simd
+              << ", threads: " << rhakt::util::resolve_threads(threads) << std::endl;
+    std::cout << std::left << std::setw(16) << "kernel" << std::right
+              << std::setw(12) << "ms"
+              << std::setw(14) << "Mvertices/s"
+              << std::setw(12) << "max diff" << std::endl;
+
+    auto row = [&](const char* name, double ms, double diff) {
+        std::cout << std::left << std::setw(16) << name << std::right << std::fixed
+                  << std::setw(12) << std::setprecision(2) << ms
+                  << std::setw(14) << std::setprecision(1) << vertices / ms / 1000.0
+                  << std::setw(12) << std::scientific << std::setprecision(1) << diff
+                  << std::defaultfloat << std::endl;
+    };
+
+    row("scalar", measure(iters, [&]{ skinning::skinScalar(ref, 0, vertices); }), 0.0);
+
+    auto t = measure(iters, [&]{ skinMesh(mesh, palette.data(), bones, positions.data(), normals.data(), 1); });
+    row("simd", t, std::max(maxDiff(refPositions, positions), maxDiff(refNormals, normals)));
+
+    std::fill(positions.begin(), positions.end(), 0.f);
+    t = measure(iters, [&]{ skinMesh(mesh, palette.data(), bones, positions.data(), normals.data(), threads); });
+    row("simd threaded", t, std::max(maxDiff(refPositions, positions), maxDiff(refNormals, normals)));
+
+    t = measure(iters, [&]{ skinMesh(mesh, palette.data(), bones, positions.data(), nullptr, threads); });
+    row("positions only", t, maxDiff(refPositions, positions));
+}
@@ -0,0 +1,139 @@
+// rechor project
+// bench_weld.cpp
+//
+// compares linear (std::find) and hash-based vertex welding
+// usage: bench_weld [triangles ...]
+
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include "rechor/vertex_welder.hpp"
+
+using namespace rhakt::rechor;
+
+namespace {
+
+    // grid of quads, unrolled per polygon vertex like MeshRaw
+    std::vector<element_t> makeStream(std::size_t triangles, std::uint32_t seed) {
+        const auto quads = std::max<std::size_t>(1, triangles / 2);
+        const auto w = static_cast<std::size_t>(std::sqrt(static_cast<double>(quads))) + 1;
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<uint> bone(0, 63);
+
+        auto corner = [&](std::size_t x, std::size_t y) {
+            const auto fx = static_cast<float>(x), fy = static_cast<float>(y);
+            const auto b = static_cast<uint>((x + y) % 64);
+            return std::make_tuple(
+                vertex_t{{ fx, 0.f, fy }},
+                normal_t{{ 0.f, 1.f, 0.f }},
+                color_t{{ 1.f, 1.f, 1.f, 1.f }},
+                uv_t{{ fx / w, fy / w }},
+                bindex_t{{ b, (b + 1) % 64, 0U, 0U }},
+                bweight_t{{ 0.75f, 0.25f, 0.f, 0.f }}
+            );
+        };
+
+        std::vector<element_t> stream;
+        stream.reserve(quads * 6);
+        for(std::size_t q = 0; q < quads; q++) {
+            const auto x = q % w, y = q / w;
+            stream.push_back(corner(x, y));
+            stream.push_back(corner(x + 1, y));
+            stream.push_back(corner(x, y + 1));
+            stream.push_back(corner(x + 1, y));
+            stream.push_back(corner(x + 1, y + 1));
+            stream.push_back(corner(x, y + 1));
+        }
+        // seams: split some vertices by uv so the stream is not perfectly shared
+        for(auto&& e : stream) {
+            if(bone(rng) == 0) { std::get<3>(e)[0] += 1.f; }
+        }
+        return stream;
+    }
+
+    std::vector<uint> weldLinear(const std::vector<element_t>& stream) {
+        std::vector<element_t> cache;
+        std::vector<uint> indices;
+        indices.reserve(stream.size());
+        for(auto&& e : stream) {
+            auto it = std::find(cache.begin(), cache.end(), e);
+            if(it == cache.end()) {
+                indices.push_back(static_cast<uint>(cache.size()));
+                cache.push_back(e);
+            } else {
+                indices.push_back(static_cast<uint>(std::distance(cache.begin(), it)));
+            }
+        }
+        return indices;
+    }
+
+    std::vector<uint> weldHash(const std::vector<element_t>& stream) {
+        VertexWelder welder(stream.size());
+        std::vector<uint> indices;
+        indices.reserve(stream.size());
+        for(auto&& e : stream) {
+            indices.push_back(welder.weld(e).first);
+        }
+        return indices;
+    }
+
+    template <typename F>
+    double measure(F&& f) {
+        const auto begin = std::chrono::high_resolution_clock::now();
+        f();
+        const auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - begin).count();
+    }
+
+} // namespace
+
+auto main(int argc, char* argv[])-> int {
+
+    std::vector<std::size_t> sizes;
+    for(int i = 1; i < argc; i++) {
+        sizes.push_back(static_cast<std::size_t>(std::strtoull(argv[i], nullptr, 10)));
+    }
+    if(sizes.empty()) {
+        sizes = { 1000, 10000, 50000, 200000 };
+    }
+
+    // O(n^2) reference becomes unbearable beyond this
+    const std::size_t linearLimit = 60000;
+
+    std::cout << std::setw(10) << "triangles"
+              << std::setw(10) << "unique"
+              << std::setw(14) << "linear[ms]"
+              << std::setw(14) << "hash[ms]"
+              << std::setw(10) << "speedup" << std::endl;
+
+    for(auto&& n : sizes) {
+        const auto stream = makeStream(n, 1234);
+        std::vector<uint> a, b;
+
+        const auto th = measure([&]{ b = weldHash(stream); });
+        const auto unique = *std::max_element(b.begin(), b.end()) + 1;
+
+        std::cout << std::setw(10) << stream.size() / 3
+                  << std::setw(10) << unique;
+        if(n <= linearLimit) {
+            const auto tl = measure([&]{ a = weldLinear(stream); });
+            if(a != b) {
+                std::cerr << "index buffer mismatch" << std::endl;
+                return -1;
+            }
+            std::cout << std::setw(14) << std::fixed << std::setprecision(2) << tl
+                      << std::setw(14) << th
+                      << std::setw(10) << std::setprecision(1) << tl / th << std::endl;
+        } else {
+            std::cout << std::setw(14) << "-"
+                      << std::setw(14) << std::fixed << std::setprecision(2) << th
+                      << std::setw(10) << "-" << std::endl;
+        }
+    }
+}
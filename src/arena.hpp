@@ -0,0 +1,166 @@
+// rechor project
+// arena.hpp
+
+#ifndef _RHACT_ARENA_HPP_
+#define _RHACT_ARENA_HPP_
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+
+#include "util.hpp"
+
+namespace rhakt {
+namespace util {
+
+    /*
+     * monotonic arena: allocations bump a pointer through chunks that are
+     * only returned as a whole (reset / destructor). not thread safe.
+     */
+    class Arena : private Noncopyable {
+    private:
+        struct Chunk {
+            Chunk* next;
+            std::size_t size;           // usable bytes after the header
+        };
+
+        static const std::size_t ALIGN = alignof(std::max_align_t);
+        static const std::size_t HEADER = (sizeof(Chunk) + ALIGN - 1) & ~(ALIGN - 1);
+
+        Chunk* chunks_;                 // newest first
+        char* cur_;
+        char* end_;
+        char* last_;                    // most recent allocation (shrinks back on deallocate)
+        std::size_t next_;              // size of the next chunk
+        std::size_t used_;
+        std::size_t capacity_;
+
+        static char* data(Chunk* c) { return reinterpret_cast<char*>(c) + HEADER; }
+
+        void grow(std::size_t bytes) {
+            const auto size = std::max(next_, bytes);
+            auto c = static_cast<Chunk*>(::operator new(HEADER + size));
+            c->next = chunks_;
+            c->size = size;
+            chunks_ = c;
+            cur_ = data(c);
+            end_ = cur_ + size;
+            last_ = nullptr;
+            capacity_ += size;
+            next_ = std::min<std::size_t>(next_ * 2, 64 << 20);
+        }
+
+        void freeChunks(Chunk* c) {
+            while(c) {
+                const auto next = c->next;
+                ::operator delete(c);
+                c = next;
+            }
+        }
+
+    public:
+        // the first chunk is allocated on demand; reserve() sizes it up front
+        explicit Arena(std::size_t chunkSize = 64 << 10)
+            : chunks_(nullptr), cur_(nullptr), end_(nullptr), last_(nullptr), next_(std::max<std::size_t>(chunkSize, 256)), used_(0), capacity_(0) {}
+        ~Arena() { freeChunks(chunks_); }
+
+        void* allocate(std::size_t bytes, std::size_t align = ALIGN) {
+            auto p = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(cur_) + align - 1) & ~static_cast<std::uintptr_t>(align - 1));
+            if(!cur_ || p + bytes > end_) {
+                grow(bytes + align);
+                p = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(cur_) + align - 1) & ~static_cast<std::uintptr_t>(align - 1));
+            }
+            used_ += bytes + (p - cur_);
+            cur_ = p + bytes;
+            last_ = p;
+            return p;
+        }
+
+        // only the latest allocation is given back (a vector growing at the top)
+        void deallocate(void* p, std::size_t bytes) {
+            if(p && p == last_ && static_cast<char*>(p) + bytes == cur_) {
+                cur_ = last_;
+                used_ -= bytes;
+                last_ = nullptr;
+            }
+        }
+
+        // room for at least bytes more without another chunk
+        void reserve(std::size_t bytes) {
+            if(static_cast<std::size_t>(end_ - cur_) < bytes) {
+                next_ = std::max(next_, bytes);
+                grow(bytes);
+            }
+        }
+
+        /*
+         * everything allocated so far becomes invalid. the memory is kept, merged
+         * into one chunk, so a load of the same size fits without growing again.
+         */
+        void reset() {
+            if(!chunks_) { return; }
+            if(chunks_->next) {
+                const auto total = capacity_;
+                release();
+                grow(total);
+            }
+            cur_ = data(chunks_);
+            end_ = cur_ + chunks_->size;
+            last_ = nullptr;
+            used_ = 0;
+        }
+
+        // everything allocated so far becomes invalid and every chunk is freed
+        void release() {
+            freeChunks(chunks_);
+            chunks_ = nullptr;
+            cur_ = end_ = last_ = nullptr;
+            used_ = 0;
+            capacity_ = 0;
+        }
+
+        std::size_t used() const { return used_; }
+        std::size_t capacity() const { return capacity_; }
+    };
+
+    /* std allocator over an Arena; deallocate is (mostly) a no-op */
+    template <typename T>
+    class ArenaAllocator {
+    private:
+        template <typename U> friend class ArenaAllocator;
+        Arena* arena_;
+
+    public:
+        typedef T value_type;
+
+        ArenaAllocator(Arena& arena) : arena_(&arena) {}
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena_) {}
+
+        T* allocate(std::size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T* p, std::size_t n) { arena_->deallocate(p, n * sizeof(T)); }
+
+        /*
+         * default-initializes instead of value-initializing, like new T[n]:
+         * resize(n) leaves arithmetic elements uninitialized so a vector can be
+         * sized and then filled with one memcpy.
+         */
+        template <typename U>
+        void construct(U* p) { ::new(static_cast<void*>(p)) U; }
+        template <typename U, typename... Args>
+        void construct(U* p, Args&&... args) { ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+
+        // not propagated on assignment: a container stays in the arena it was made in
+        Arena& arena() const { return *arena_; }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.arena_; }
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.arena_; }
+    };
+
+}} // namespace rhakt::util
+
+#endif
@@ -1,8 +1,165 @@
 #include "logger.hpp"
 
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
 namespace rhakt {
 
-LOGLEVEL logger::level = LOGLEVEL::INFO;
+std::atomic<LOGLEVEL> logger::level(LOGLEVEL::INFO);
 
-} // namespace rhakt
+namespace {
+
+    /*
+     * bounded multi-producer ring (Vyukov): a producer claims a slot with one CAS
+     * on head_, fills it and publishes it through the slot's sequence number.
+     * a single writer thread consumes in claim order and batches the flushes.
+     */
+    class Backend {
+    private:
+        struct Slot {
+            std::atomic<std::size_t> seq;
+            LOGLEVEL level;
+            std::string text;
+        };
+
+        static const std::size_t CAPACITY = 4096;   // power of two
+        static const int PUSH_RETRIES = 1024;       // yields before a record is dropped
+
+        std::unique_ptr<Slot[]> slots_;
+        std::atomic<std::size_t> head_;
+        std::size_t tail_;                          // writer thread only
+        std::atomic<std::size_t> pushed_;
+        std::atomic<std::size_t> written_;
+        std::atomic<std::size_t> dropped_;
+        std::atomic<bool> stop_;
+
+        std::mutex wakeMutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+
+        std::mutex outMutex_;                       // guards file_ against setOutput
+        std::ofstream file_;
+
+        std::thread thread_;
+
+        bool tryPush(LOGLEVEL lv, std::string& text) {
+            auto pos = head_.load(std::memory_order_relaxed);
+            for(;;) {
+                auto& slot = slots_[pos & (CAPACITY - 1)];
+                const auto seq = slot.seq.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if(diff == 0) {
+                    if(head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        slot.level = lv;
+                        slot.text.swap(text);
+                        slot.seq.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if(diff < 0) {
+                    return false;   // full
+                } else {
+                    pos = head_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // writes everything published so far, returns the number of records
+        std::size_t drain() {
+            std::lock_guard<std::mutex> lock(outMutex_);
+            std::size_t n = 0;
+            for(;;) {
+                auto& slot = slots_[tail_ & (CAPACITY - 1)];
+                if(slot.seq.load(std::memory_order_acquire) != tail_ + 1) { break; }
+                auto& out = file_.is_open() ? static_cast<std::ostream&>(file_) : (slot.level == LOGLEVEL::ERR ? std::cerr : std::cout);
+                out << slot.text << '\n';
+                slot.text.clear();
+                slot.seq.store(tail_ + CAPACITY, std::memory_order_release);
+                tail_++;
+                n++;
+            }
+            const auto dropped = dropped_.exchange(0);
+            if(dropped > 0) {
+                auto& out = file_.is_open() ? static_cast<std::ostream&>(file_) : std::cerr;
+                out << "[WARN] " << dropped << " log records dropped\n";
+            }
+            if(n > 0 || dropped > 0) {
+                if(file_.is_open()) { file_.flush(); }
+                std::cout.flush();
+                std::cerr.flush();
+            }
+            written_ += n;
+            return n;
+        }
+
+        void run() {
+            while(!stop_.load(std::memory_order_acquire)) {
+                if(drain() > 0) {
+                    done_.notify_all();
+                    continue;
+                }
+                // producers never notify, so poll at a short interval
+                std::unique_lock<std::mutex> lock(wakeMutex_);
+                done_.notify_all();
+                wake_.wait_for(lock, std::chrono::milliseconds(2));
+            }
+            drain();
+            done_.notify_all();
+        }
 
+    public:
+        Backend() : slots_(new Slot[CAPACITY]), head_(0), tail_(0), pushed_(0), written_(0), dropped_(0), stop_(false) {
+            for(std::size_t i = 0; i < CAPACITY; i++) { slots_[i].seq.store(i, std::memory_order_relaxed); }
+            thread_ = std::thread([this]() { run(); });
+        }
+
+        ~Backend() {
+            stop_.store(true, std::memory_order_release);
+            wake_.notify_all();
+            thread_.join();
+        }
+
+        void push(LOGLEVEL lv, std::string& text) {
+            for(int i = 0; i < PUSH_RETRIES; i++) {
+                if(tryPush(lv, text)) {
+                    pushed_++;
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            dropped_++;
+        }
+
+        void flush() {
+            const auto target = pushed_.load();
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wake_.notify_all();
+            done_.wait(lock, [&]() { return written_.load() >= target || stop_.load(); });
+        }
+
+        bool setOutput(const std::string& filename) {
+            flush();
+            std::lock_guard<std::mutex> lock(outMutex_);
+            file_.close();
+            if(filename.empty()) { return true; }
+            file_.open(filename, std::ofstream::app);
+            return file_.is_open();
+        }
+    };
+
+    Backend& backend() {
+        static Backend b;
+        return b;
+    }
+
+} // namespace
+
+void logger::push(LOGLEVEL lv, std::string&& text) { backend().push(lv, text); }
+
+bool logger::setOutput(const std::string& filename) { return backend().setOutput(filename); }
+
+void logger::flush() { backend().flush(); }
+
+} // namespace rhakt
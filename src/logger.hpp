@@ -7,14 +7,26 @@
 #include <fstream>
 #include <string>
 #include <iterator>
+#include <atomic>
 
-#define LOG_FUNC_GEN(name, lv, method, prefix, suffix) \
+// levels below this are compiled out (0: keep everything, 1: drop debug, ...)
+#ifndef RECHOR_LOG_MIN_LEVEL
+#define RECHOR_LOG_MIN_LEVEL 0
+#endif
+
+/*
+ * the record is formatted on the calling thread and handed to the
+ * background writer; the caller never waits for I/O.
+ */
+#define LOG_FUNC_GEN(name, lv, prefix) \
     template <typename... Args> \
     static void name(const Args&... args) { \
-        if(level > LOGLEVEL::lv ) { return; } \
-        std::stringstream ss; \
-        stringify(ss,args...); \
-        std::method << prefix << ss.str() << suffix << std::endl; \
+        if(static_cast<int>(LOGLEVEL::lv) < RECHOR_LOG_MIN_LEVEL) { return; } \
+        if(level.load(std::memory_order_relaxed) > LOGLEVEL::lv) { return; } \
+        auto& ss = stream(); \
+        ss << prefix; \
+        stringify(ss, args...); \
+        push(LOGLEVEL::lv, ss.str()); \
     }
 
 namespace rhakt {
@@ -38,27 +50,44 @@ enum struct LOGLEVEL : int {
 };
 
 struct logger {
-private:	
-    static LOGLEVEL level;
-    
-    static void stringify(std::stringstream& ss) {}
+private:
+    static std::atomic<LOGLEVEL> level;
+
+    static void stringify(std::ostringstream& ss) {}
 
     template <typename T, typename... Args>
-    static void stringify(std::stringstream& ss, const T& value, const Args&... args) {
+    static void stringify(std::ostringstream& ss, const T& value, const Args&... args) {
         ss << value;
         stringify(ss, args...);
     }
 
+    // reused per thread, so formatting does not construct a stream per line
+    static std::ostringstream& stream() {
+        static thread_local std::ostringstream ss;
+        ss.str(std::string());
+        ss.clear();
+        return ss;
+    }
+
+    // enqueue for the writer thread (drops the record if the queue stays full)
+    static void push(LOGLEVEL lv, std::string&& text);
+
 public:
-    static void setLevel(const LOGLEVEL lv){ level = lv; }
+    static void setLevel(const LOGLEVEL lv){ level.store(lv, std::memory_order_relaxed); }
+
+    // write to filename instead of stdout/stderr (empty: back to the console)
+    static bool setOutput(const std::string& filename);
+
+    // blocks until everything logged so far is written
+    static void flush();
 
-    LOG_FUNC_GEN(debug, DEBUG,  cout,   "[DEBUG] ", "")
-    LOG_FUNC_GEN(info,  INFO,   cout,   "[INFO] ",  "");
-    LOG_FUNC_GEN(warn,  WARN,   cout,   "[WARN] ",  "");
-    LOG_FUNC_GEN(error, ERR,    cerr,   "[ERROR] ", "");
-    LOG_FUNC_GEN(log,   LOG,    cout,   "", "");
+    LOG_FUNC_GEN(debug, DEBUG,  "[DEBUG] ")
+    LOG_FUNC_GEN(info,  INFO,   "[INFO] ")
+    LOG_FUNC_GEN(warn,  WARN,   "[WARN] ")
+    LOG_FUNC_GEN(error, ERR,    "[ERROR] ")
+    LOG_FUNC_GEN(log,   LOG,    "")
 };
 
 } // namespace rhakt
 
-#endif
\ No newline at end of file
+#endif
@@ -2,8 +2,73 @@
 // main.cpp
 
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
 #include "main.hpp"
 
+namespace {
+
+    // errors logged before (asynchronously) come out ahead of the usage text
+    void usage() {
+        rhakt::logger::flush();
+        std::cout <<
+            "usage: rechor [options] <job>...\n"
+            "  job: mesh.fbx[+anim.fbx...][=out.rkr] or @manifest.txt\n"
+            "       manifest: one job per line, \"mesh.fbx [anim.fbx ...] [> out.rkr]\", '#' comments\n"
+            "options:\n"
+            "  -j N              convert N files at once (0: hardware threads, default)\n"
+            "  -t N              threads inside one conversion (default 1)\n"
+            "  -o DIR            output directory (default: next to the mesh)\n"
+            "  -c none|lz4       codec (default lz4)\n"
+            "  -g                attach NAME_*.fbx to NAME.fbx as animations\n"
+            "  --chunked         chunked container\n"
+            "  --no-filter       no stream filters before LZ4\n"
+            "  --pack            packed (quantized) vertices\n"
+            "  --interleave      interleaved vertex blob\n"
+            "  --quantize-bones  quantized bone TRS\n"
+            "  --optimize        vertex cache and overdraw optimization\n"
+            "  --reduce          keyframe reduction\n"
+            "  --lods R,R,...    LOD chain at these triangle ratios (e.g. 0.5,0.25,0.125);\n"
+            "                    vertices are then ordered coarsest level first, overriding\n"
+            "                    the vertex fetch order of --optimize\n"
+            "  --meshlets        meshlets of 64 vertices / 124 triangles with culling bounds\n"
+            "  --cache DIR       reuse outputs of unchanged inputs from DIR\n"
+            "  --cache-size MB   LRU limit of the cache (default 1024)\n"
+#ifdef RECHOR_ENABLE_TRACE
+            "  --trace FILE      write a Chrome trace_event JSON of all phases\n"
+#endif
+            "  -v                verbose\n";
+    }
+
+    // "0.5,0.25,...": strictly descending ratios in (0, 1], false on anything else
+    bool parseRatios(const std::string& list, std::vector<float>& ratios) {
+        ratios.clear();
+        for(std::size_t p = 0; ; ) {
+            const auto q = std::min(list.find(',', p), list.size());
+            const auto item = list.substr(p, q - p);
+            char* end = nullptr;
+            const auto r = std::strtof(item.c_str(), &end);
+            if(item.empty() || *end != '\0' || !(r > 0.f && r <= 1.f) || (!ratios.empty() && r >= ratios.back())) { return false; }
+            ratios.push_back(r);
+            if(q == list.size()) { return true; }
+            p = q + 1;
+        }
+    }
+
+    // decimal digits only, at most max; false on anything else
+    bool parseCount(const std::string& text, unsigned long long max, unsigned long long& value) {
+        if(text.empty() || text[0] < '0' || text[0] > '9') { return false; }
+        char* end = nullptr;
+        errno = 0;
+        value = std::strtoull(text.c_str(), &end, 10);
+        return *end == '\0' && errno != ERANGE && value <= max;
+    }
+
+}
+
 auto main(int argc, char* argv[])-> int {
 
 #if _DEBUG && _MSC_VER
@@ -16,50 +81,104 @@ auto main(int argc, char* argv[])-> int {
 #endif
     using namespace rhakt;
 
-    logger::setLevel(LOGLEVEL::DEBUG);
+    logger::setLevel(LOGLEVEL::WARN);
 
-    logger::info("[RECHOR]");
+    rechor::BatchOptions options;
+    std::vector<std::string> specs;
+    bool group = false;
+    std::string tracefile;
 
-    const char* fi = "model/unitychan.fbx";
-    const char* fi2 = "model/unitychan_WAIT04.fbx";
-    const char* fi3 = "model/unitychan_WIN00.fbx";
-    const char* fo = "model/unitychan.rkr";
-    const char* fo2 = "model/unitychan2.rkr";
-    
-    rechor::FBXImporter importer;
-    rechor::Exporter exporter, reexporter;
-    rechor::Importer reimporter;
-    rechor::Scene scene, scene2;
-    
-    using OPTION = rechor::FBXImporter::OPTION;
-    
-    if(!importer.load(fi, OPTION::LOAD_MESH | OPTION::LOAD_BONEWEIGHT)) {
-        logger::error("fail to load ", '"', fi, '"');
-        return -1;
-    }
-    if(!importer.load(fi2, OPTION::LOAD_ANIM)) {
-        logger::error("fail to load ", '"', fi2, '"');
-        return -1;
-    }
-    if(!importer.load(fi3, scene, OPTION::LOAD_ANIM)) {
-        logger::error("fail to load ", '"', fi3, '"');
-        return -1;
+    for(int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const auto value = [&]() -> std::string {
+            if(i + 1 >= argc) {
+                logger::error("missing value for ", arg);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if(arg == "-h" || arg == "--help") { usage(); return 0; }
+        else if(arg == "-j" || arg == "-t") {
+            const auto text = value();
+            unsigned long long n = 0;
+            if(!parseCount(text, UINT_MAX, n)) {
+                logger::error(arg, " wants a thread count, got ", '"', text, '"');
+                usage();
+                return 2;
+            }
+            (arg == "-j" ? options.workers : options.threads) = static_cast<rechor::uint>(n);
+        }
+        else if(arg == "-o") { options.outputDir = value(); }
+        else if(arg == "-c") {
+            const auto codec = value();
+            if(codec == "none") { options.codec = rechor::CODEC::NONE; }
+            else if(codec == "lz4") { options.codec = rechor::CODEC::LZ4; }
+            else {
+                logger::error("unknown codec ", '"', codec, '"');
+                return 2;
+            }
+        }
+        else if(arg == "-g") { group = true; }
+        else if(arg == "-v") { logger::setLevel(LOGLEVEL::DEBUG); }
+        else if(arg == "--chunked") { options.chunked = true; }
+        else if(arg == "--no-filter") { options.filter = false; }
+        else if(arg == "--pack") { options.packVertices = true; }
+        else if(arg == "--interleave") { options.interleave = true; }
+        else if(arg == "--quantize-bones") { options.quantizeBones = true; }
+        else if(arg == "--optimize") { options.optimize = true; }
+        else if(arg == "--reduce") { options.reduceKeys = true; }
+        else if(arg == "--lods") {
+            const auto list = value();
+            if(!parseRatios(list, options.lods.ratios)) {
+                logger::error("--lods wants descending ratios in (0, 1], got ", '"', list, '"');
+                usage();
+                return 2;
+            }
+            options.generateLods = true;
+        }
+        else if(arg == "--meshlets") { options.buildMeshlets = true; }
+        else if(arg == "--cache") { options.cacheDir = value(); }
+        else if(arg == "--cache-size") {
+            const auto text = value();
+            unsigned long long mb = 0;
+            if(!parseCount(text, UINT64_MAX >> 20, mb)) {
+                logger::error("--cache-size wants megabytes up to ", UINT64_MAX >> 20, ", got ", '"', text, '"');
+                usage();
+                return 2;
+            }
+            options.cacheBytes = static_cast<std::uint64_t>(mb) << 20;
+        }
+#ifdef RECHOR_ENABLE_TRACE
+        else if(arg == "--trace") { tracefile = value(); }
+#endif
+        else if(arg.size() > 1 && arg[0] == '-') {
+            logger::error("unknown option ", arg);
+            usage();
+            return 2;
+        }
+        else { specs.push_back(arg); }
     }
- 
-    if(!exporter.save(fo, scene)) {
-        logger::error("fail to save ", '"', fo, '"');
-        return -1;
+
+    std::vector<rechor::ConvertJob> jobs;
+    for(auto&& spec : specs) {
+        if(spec[0] == '@') {
+            if(!rechor::batch::loadManifest(spec.substr(1), options.outputDir, jobs)) { return 2; }
+        } else {
+            jobs.push_back(rechor::batch::parseJob(spec, options.outputDir));
+        }
     }
-    
-    if(!reimporter.load(fo, scene2)) {
-        logger::error("fail to load ", '"', fo, '"');
-        return -1;
+    if(jobs.empty()) {
+        usage();
+        return 2;
     }
-    
-    if(!reexporter.save(fo2, scene2)) {
-        logger::error("fail to save ", '"', fo2, '"');
-        return -1;
+    if(group) { rechor::batch::groupByName(jobs); }
+
+    rechor::BatchConverter converter(options);
+    const auto failed = converter.run(jobs);
+#ifdef RECHOR_ENABLE_TRACE
+    if(!tracefile.empty() && !trace::write(tracefile.c_str())) {
+        logger::error("fail to write ", '"', tracefile, '"');
     }
-    logger::info("finish!");
-    
-}
\ No newline at end of file
+#endif
+    return failed == 0 ? 0 : 1;
+}
@@ -12,6 +12,7 @@
 #include "rechor/rechor_importer.hpp"
 #include "rechor/rechor_exporter.hpp"
 #include "rechor/fbx_importer.hpp"
+#include "rechor/batch_converter.hpp"
 
 
 #endif
@@ -0,0 +1,50 @@
+// rechor project
+// parallel.hpp
+
+#ifndef _RHACT_PARALLEL_HPP_
+#define _RHACT_PARALLEL_HPP_
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+namespace rhakt {
+namespace util {
+
+    // 0 means one thread per hardware thread
+    inline unsigned int resolve_threads(unsigned int threads) {
+        if(threads > 0) { return threads; }
+        const auto hc = std::thread::hardware_concurrency();
+        return hc > 0 ? hc : 1;
+    }
+
+    /*
+     * calls fn(i) for every i in [0, n) on up to `threads` workers.
+     * workers pull the next index from a shared counter, so uneven
+     * items balance themselves. runs inline when one thread is enough.
+     */
+    template <typename F>
+    void parallel_for(std::size_t n, unsigned int threads, F&& fn) {
+        const auto tc = static_cast<std::size_t>(std::min<std::size_t>(resolve_threads(threads), n));
+        if(tc <= 1) {
+            for(std::size_t i = 0; i < n; i++) { fn(i); }
+            return;
+        }
+        std::atomic<std::size_t> next(0);
+        auto work = [&]() {
+            for(auto i = next++; i < n; i = next++) { fn(i); }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(tc - 1);
+        for(std::size_t t = 1; t < tc; t++) {
+            workers.emplace_back(work);
+        }
+        work();
+        for(auto&& w : workers) { w.join(); }
+    }
+
+}} // namespace rhakt::util
+
+#endif
@@ -0,0 +1,137 @@
+// rechor project
+// anim_math.hpp
+//
+// matrices are 16 floats in FBX layout (row vectors):
+// rows 0-2 hold the scaled basis, row 3 the translation.
+
+#ifndef _RHACT_RECHOR_ANIM_MATH_HPP_
+#define _RHACT_RECHOR_ANIM_MATH_HPP_
+
+#include <cmath>
+#include <algorithm>
+
+namespace rhakt {
+namespace rechor {
+
+    /* translation, rotation quaternion (x, y, z, w), scale */
+    struct TRS {
+        float t[3];
+        float r[4];
+        float s[3];
+    };
+
+    namespace animmath {
+
+        inline float dot4(const float* a, const float* b) {
+            return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        }
+
+        inline void normalize4(float* q) {
+            const auto l = std::sqrt(dot4(q, q));
+            if(l > 0.f) { for(int i = 0; i < 4; i++) { q[i] /= l; } }
+        }
+
+        // rotation angle between two unit quaternions [rad]
+        inline float angle(const float* a, const float* b) {
+            const auto d = std::min(std::fabs(dot4(a, b)), 1.f);
+            return 2.f * std::acos(d);
+        }
+
+        inline void decompose(const float* m, TRS& trs) {
+            float rows[3][3];
+            for(int i = 0; i < 3; i++) {
+                const auto l = std::sqrt(m[i * 4] * m[i * 4] + m[i * 4 + 1] * m[i * 4 + 1] + m[i * 4 + 2] * m[i * 4 + 2]);
+                trs.s[i] = l;
+                for(int k = 0; k < 3; k++) { rows[i][k] = l > 0.f ? m[i * 4 + k] / l : (i == k ? 1.f : 0.f); }
+                trs.t[i] = m[12 + i];
+            }
+            // mirrored basis: move the sign into the scale
+            const auto det =
+                rows[0][0] * (rows[1][1] * rows[2][2] - rows[1][2] * rows[2][1]) -
+                rows[0][1] * (rows[1][0] * rows[2][2] - rows[1][2] * rows[2][0]) +
+                rows[0][2] * (rows[1][0] * rows[2][1] - rows[1][1] * rows[2][0]);
+            if(det < 0.f) {
+                trs.s[0] = -trs.s[0];
+                for(int k = 0; k < 3; k++) { rows[0][k] = -rows[0][k]; }
+            }
+
+            auto& q = trs.r;
+            const auto tr = rows[0][0] + rows[1][1] + rows[2][2];
+            if(tr > 0.f) {
+                const auto s = std::sqrt(tr + 1.f) * 2.f;
+                q[3] = 0.25f * s;
+                q[0] = (rows[2][1] - rows[1][2]) / s;
+                q[1] = (rows[0][2] - rows[2][0]) / s;
+                q[2] = (rows[1][0] - rows[0][1]) / s;
+            } else if(rows[0][0] > rows[1][1] && rows[0][0] > rows[2][2]) {
+                const auto s = std::sqrt(1.f + rows[0][0] - rows[1][1] - rows[2][2]) * 2.f;
+                q[3] = (rows[2][1] - rows[1][2]) / s;
+                q[0] = 0.25f * s;
+                q[1] = (rows[0][1] + rows[1][0]) / s;
+                q[2] = (rows[0][2] + rows[2][0]) / s;
+            } else if(rows[1][1] > rows[2][2]) {
+                const auto s = std::sqrt(1.f + rows[1][1] - rows[0][0] - rows[2][2]) * 2.f;
+                q[3] = (rows[0][2] - rows[2][0]) / s;
+                q[0] = (rows[0][1] + rows[1][0]) / s;
+                q[1] = 0.25f * s;
+                q[2] = (rows[1][2] + rows[2][1]) / s;
+            } else {
+                const auto s = std::sqrt(1.f + rows[2][2] - rows[0][0] - rows[1][1]) * 2.f;
+                q[3] = (rows[1][0] - rows[0][1]) / s;
+                q[0] = (rows[0][2] + rows[2][0]) / s;
+                q[1] = (rows[1][2] + rows[2][1]) / s;
+                q[2] = 0.25f * s;
+            }
+            normalize4(q);
+        }
+
+        inline void compose(const TRS& trs, float* m) {
+            const auto x = trs.r[0], y = trs.r[1], z = trs.r[2], w = trs.r[3];
+            const float rows[3][3] = {
+                { 1.f - 2.f * (y * y + z * z), 2.f * (x * y - z * w), 2.f * (x * z + y * w) },
+                { 2.f * (x * y + z * w), 1.f - 2.f * (x * x + z * z), 2.f * (y * z - x * w) },
+                { 2.f * (x * z - y * w), 2.f * (y * z + x * w), 1.f - 2.f * (x * x + y * y) },
+            };
+            for(int i = 0; i < 3; i++) {
+                for(int k = 0; k < 3; k++) { m[i * 4 + k] = rows[i][k] * trs.s[i]; }
+                m[i * 4 + 3] = 0.f;
+                m[12 + i] = trs.t[i];
+            }
+            m[15] = 1.f;
+        }
+
+        // shortest path spherical interpolation of unit quaternions
+        inline void slerp(const float* a, const float* b, float t, float* out) {
+            float bb[4] = { b[0], b[1], b[2], b[3] };
+            auto d = dot4(a, bb);
+            if(d < 0.f) {
+                d = -d;
+                for(int i = 0; i < 4; i++) { bb[i] = -bb[i]; }
+            }
+            float wa, wb;
+            if(d > 0.9995f) {
+                wa = 1.f - t;
+                wb = t;
+            } else {
+                const auto th = std::acos(d);
+                const auto sn = std::sin(th);
+                wa = std::sin((1.f - t) * th) / sn;
+                wb = std::sin(t * th) / sn;
+            }
+            for(int i = 0; i < 4; i++) { out[i] = wa * a[i] + wb * bb[i]; }
+            normalize4(out);
+        }
+
+        inline void interpolate(const TRS& a, const TRS& b, float t, TRS& out) {
+            for(int i = 0; i < 3; i++) {
+                out.t[i] = a.t[i] + (b.t[i] - a.t[i]) * t;
+                out.s[i] = a.s[i] + (b.s[i] - a.s[i]) * t;
+            }
+            slerp(a.r, b.r, t, out.r);
+        }
+
+    } // namespace animmath
+
+}} // namespace rhakt::rechor
+
+#endif
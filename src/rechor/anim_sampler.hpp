@@ -0,0 +1,281 @@
+// rechor project
+// anim_sampler.hpp
+//
+// poses of a loaded Anim at arbitrary times: interpolated bone palettes
+// (16 floats per bone, FBX layout) written into caller buffers.
+
+#ifndef _RHACT_RECHOR_ANIM_SAMPLER_HPP_
+#define _RHACT_RECHOR_ANIM_SAMPLER_HPP_
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__AVX__)
+#define RECHOR_SAMPLER_AVX
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RECHOR_SAMPLER_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "rechor.hpp"
+#include "anim_math.hpp"
+#include "keyframe_reducer.hpp"
+#include "../parallel.hpp"
+
+namespace rhakt {
+namespace rechor {
+
+    // frames per second the FBX importer bakes at
+    static const float ANIM_FRAME_RATE = 60.f;
+
+    enum struct SAMPLE_MODE : uchar {
+        NEAREST = 0,    // closest baked frame, no blending
+        LERP = 1,       // componentwise matrix lerp (fast, slightly shrinks rotations in between)
+        SLERP = 2       // decomposed TRS: lerp translation/scale, slerp rotation
+    };
+
+    enum struct SAMPLE_WRAP : uchar {
+        CLAMP = 0,      // hold the first/last frame outside the clip
+        LOOP = 1        // repeat the clip
+    };
+
+    namespace sampler {
+
+        /* out = a + (b - a) * t over n floats */
+        inline void lerp(const float* a, const float* b, float t, float* out, std::size_t n) {
+            std::size_t i = 0;
+#ifdef RECHOR_SAMPLER_AVX
+            const auto t8 = _mm256_set1_ps(t);
+            for(; i + 8 <= n; i += 8) {
+                const auto va = _mm256_loadu_ps(a + i);
+                const auto vb = _mm256_loadu_ps(b + i);
+                _mm256_storeu_ps(out + i, _mm256_add_ps(va, _mm256_mul_ps(_mm256_sub_ps(vb, va), t8)));
+            }
+#endif
+#ifdef RECHOR_SAMPLER_SSE2
+            const auto t4 = _mm_set1_ps(t);
+            for(; i + 4 <= n; i += 4) {
+                const auto va = _mm_loadu_ps(a + i);
+                const auto vb = _mm_loadu_ps(b + i);
+                _mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), t4)));
+            }
+#endif
+            for(; i < n; i++) {
+                out[i] = a[i] + (b[i] - a[i]) * t;
+            }
+        }
+
+        // two neighbouring frames and the weight of the second
+        struct Cursor {
+            std::size_t f0;
+            std::size_t f1;
+            float t;
+        };
+
+        inline Cursor locate(std::size_t frameCount, float frame, SAMPLE_WRAP wrap) {
+            Cursor c = { 0, 0, 0.f };
+            if(frameCount <= 1 || !(frame == frame)) { return c; }
+            const auto last = static_cast<float>(frameCount - 1);
+            if(wrap == SAMPLE_WRAP::LOOP) {
+                frame = std::fmod(frame, last);
+                if(frame < 0.f) { frame += last; }
+            }
+            frame = std::min(std::max(frame, 0.f), last);
+            c.f0 = std::min(static_cast<std::size_t>(frame), frameCount - 2);
+            c.f1 = c.f0 + 1;
+            c.t = frame - static_cast<float>(c.f0);
+            return c;
+        }
+
+        inline void loadPose(const float* p, TRS& trs) {
+            std::copy(p, p + 3, trs.t);
+            std::copy(p + 3, p + 7, trs.r);
+            std::copy(p + 7, p + 10, trs.s);
+        }
+
+        inline void storePose(const TRS& trs, float* p) {
+            std::copy(trs.t, trs.t + 3, p);
+            std::copy(trs.r, trs.r + 4, p + 3);
+            std::copy(trs.s, trs.s + 3, p + 7);
+        }
+
+    } // namespace sampler
+
+    /*
+     * samples the tracks of one Anim. the Anim must outlive the sampler and
+     * stay unchanged; sampling is const and may run on many threads at once.
+     * reduced tracks (keyframe_reducer.hpp) are always decoded with slerp.
+     */
+    template <typename S>
+    class BasicAnimSampler : private util::Noncopyable {
+    private:
+        static const std::size_t POSE = 10;     // t(3) r(4) s(3)
+        static const std::size_t BLOCK = 64;    // instances per batch task
+
+        // per mesh, SLERP only: decomposed frames (bones: frame major)
+        struct Poses {
+            std::vector<float> mesh;
+            std::vector<float> bones;
+        };
+
+        const BasicAnim<S>* anim_;
+        SAMPLE_MODE mode_;
+        SAMPLE_WRAP wrap_;
+        float frameRate_;
+        uint threads_;
+        std::vector<Poses> poses_;
+
+        static void decompose(const BasicTrack<S>& track, std::vector<float>& out) {
+            const std::size_t n = track.stride / 16;
+            out.resize(static_cast<std::size_t>(track.frameCount) * n * POSE);
+            for(std::size_t f = 0; f < track.frameCount; f++) {
+                for(std::size_t b = 0; b < n; b++) {
+                    TRS trs;
+                    animmath::decompose(track.frame(f) + b * 16, trs);
+                    sampler::storePose(trs, &out[(f * n + b) * POSE]);
+                }
+            }
+        }
+
+        void prepare() {
+            poses_.clear();
+            if(mode_ != SAMPLE_MODE::SLERP) { return; }
+            poses_.resize(anim_->meshes.size());
+            util::parallel_for(poses_.size(), threads_, [&](std::size_t i) {
+                const auto& af = anim_->meshes[i];
+                if(af.reduced()) { return; }
+                decompose(af.meshMatrices, poses_[i].mesh);
+                decompose(af.boneMatrices, poses_[i].bones);
+            });
+        }
+
+        // n matrices of one track at the cursor
+        void sampleTrack(const BasicTrack<S>& track, const std::vector<float>& poses, std::size_t n, const sampler::Cursor& c, float* out) const {
+            if(track.empty() || n == 0) { return; }
+            const auto a = track.frame(c.f0);
+            if(mode_ == SAMPLE_MODE::NEAREST || c.t == 0.f || c.f0 == c.f1) {
+                const auto f = mode_ == SAMPLE_MODE::NEAREST && c.t >= 0.5f ? track.frame(c.f1) : a;
+                std::memcpy(out, f, n * 16 * sizeof(float));
+            } else if(mode_ == SAMPLE_MODE::LERP) {
+                sampler::lerp(a, track.frame(c.f1), c.t, out, n * 16);
+            } else {
+                const auto p0 = &poses[c.f0 * n * POSE];
+                const auto p1 = &poses[c.f1 * n * POSE];
+                for(std::size_t b = 0; b < n; b++) {
+                    TRS ta, tb, p;
+                    sampler::loadPose(p0 + b * POSE, ta);
+                    sampler::loadPose(p1 + b * POSE, tb);
+                    animmath::interpolate(ta, tb, c.t, p);
+                    animmath::compose(p, out + b * 16);
+                }
+            }
+        }
+
+        float frameOf(float time, std::size_t frameCount) const {
+            const auto f = time * frameRate_;
+            if(wrap_ == SAMPLE_WRAP::LOOP && frameCount > 1) {
+                const auto last = static_cast<float>(frameCount - 1);
+                const auto w = std::fmod(f, last);
+                return w < 0.f ? w + last : w;
+            }
+            return f;
+        }
+
+    public:
+        explicit BasicAnimSampler(const BasicAnim<S>& anim, SAMPLE_MODE mode = SAMPLE_MODE::LERP, SAMPLE_WRAP wrap = SAMPLE_WRAP::LOOP)
+            : anim_(&anim), mode_(mode), wrap_(wrap), frameRate_(ANIM_FRAME_RATE), threads_(1) {
+            prepare();
+        }
+
+        // workers used by the batch entry point and SLERP setup (0: hardware threads)
+        void setThreads(uint threads) { threads_ = threads; }
+
+        // SLERP decomposes every baked frame once, here
+        void setMode(SAMPLE_MODE mode) {
+            if(mode == mode_) { return; }
+            mode_ = mode;
+            prepare();
+        }
+
+        void setWrap(SAMPLE_WRAP wrap) { wrap_ = wrap; }
+        void setFrameRate(float fps) { frameRate_ = fps; }
+
+        std::size_t meshCount() const { return anim_->meshes.size(); }
+
+        std::size_t frameCount(std::size_t mesh) const {
+            const auto& af = anim_->meshes[mesh];
+            if(af.reduced()) { return af.frameCount; }
+            return std::max(af.meshMatrices.frameCount, af.boneMatrices.frameCount);
+        }
+
+        // palette size is boneCount * 16 floats
+        std::size_t boneCount(std::size_t mesh) const {
+            const auto& af = anim_->meshes[mesh];
+            return af.reduced() ? af.boneKeys.size() : af.boneMatrices.stride / 16;
+        }
+
+        // seconds from the first to the last frame
+        float duration(std::size_t mesh) const {
+            const auto fc = frameCount(mesh);
+            return fc > 1 ? static_cast<float>(fc - 1) / frameRate_ : 0.f;
+        }
+
+        /* bone palette of mesh at time [s] */
+        void sample(std::size_t mesh, float time, float* palette) const {
+            const auto& af = anim_->meshes[mesh];
+            const auto fc = frameCount(mesh);
+            if(af.reduced()) {
+                const auto f = std::min(std::max(frameOf(time, fc), 0.f), static_cast<float>(fc - 1));
+                for(std::size_t b = 0; b < af.boneKeys.size(); b++) {
+                    keyframe::decodeTrack(af.boneKeys[b].frames.data(), af.boneKeys[b].keys.data(), af.boneKeys[b].frames.size(), f, palette + b * 16);
+                }
+                return;
+            }
+            static const std::vector<float> none;
+            const auto c = sampler::locate(af.boneMatrices.frameCount, time * frameRate_, wrap_);
+            sampleTrack(af.boneMatrices, poses_.empty() ? none : poses_[mesh].bones, boneCount(mesh), c, palette);
+        }
+
+        /* 4x4 mesh matrix of mesh at time [s] (left alone if the mesh has no track) */
+        void sampleMesh(std::size_t mesh, float time, float* matrix) const {
+            const auto& af = anim_->meshes[mesh];
+            if(af.reduced()) {
+                if(af.meshKeys.frames.empty()) { return; }
+                const auto fc = frameCount(mesh);
+                const auto f = std::min(std::max(frameOf(time, fc), 0.f), static_cast<float>(fc - 1));
+                keyframe::decodeTrack(af.meshKeys.frames.data(), af.meshKeys.keys.data(), af.meshKeys.frames.size(), f, matrix);
+                return;
+            }
+            static const std::vector<float> none;
+            const auto c = sampler::locate(af.meshMatrices.frameCount, time * frameRate_, wrap_);
+            sampleTrack(af.meshMatrices, poses_.empty() ? none : poses_[mesh].mesh, 1, c, matrix);
+        }
+
+        /*
+         * batch: count instances of mesh, instance i at times[i], palettes
+         * back to back (boneCount * 16 floats each). LERP runs the SIMD
+         * kernel per instance; blocks of instances go to the workers.
+         */
+        void sample(std::size_t mesh, const float* times, std::size_t count, float* palettes) const {
+            const auto size = boneCount(mesh) * 16;
+            if(size == 0) { return; }
+            const auto blocks = (count + BLOCK - 1) / BLOCK;
+            util::parallel_for(blocks, threads_, [&](std::size_t k) {
+                const auto end = std::min(count, (k + 1) * BLOCK);
+                for(auto i = k * BLOCK; i < end; i++) {
+                    sample(mesh, times[i], palettes + i * size);
+                }
+            });
+        }
+    };
+
+    typedef BasicAnimSampler<HeapStorage> AnimSampler;
+    typedef BasicAnimSampler<ArenaStorage> ArenaAnimSampler;
+
+}} // namespace rhakt::rechor
+
+#endif
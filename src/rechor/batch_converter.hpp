@@ -0,0 +1,356 @@
+// rechor project
+// batch_converter.hpp
+
+#ifndef _RHACT_RECHOR_BATCH_CONVERTER_HPP_
+#define _RHACT_RECHOR_BATCH_CONVERTER_HPP_
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+#include "rechor.hpp"
+#include "rechor_exporter.hpp"
+#include "fbx_importer.hpp"
+#include "conversion_cache.hpp"
+#include "../parallel.hpp"
+#include "../trace.hpp"
+
+namespace rhakt {
+namespace rechor {
+
+    /* one output file: a mesh FBX and the animation-only FBXs baked against it */
+    struct ConvertJob {
+        std::string mesh;
+        std::vector<std::string> animes;
+        std::string output;
+    };
+
+    struct ConvertResult {
+        bool ok;
+        std::uint64_t inputBytes;   // all FBX files of the job
+        std::uint64_t outputBytes;
+        double seconds;
+        bool cached;                // reused from the conversion cache
+    };
+
+    struct BatchOptions {
+        uint workers;               // concurrent jobs (0: hardware threads)
+        uint threads;               // threads inside one job
+        std::string outputDir;      // empty: next to the mesh FBX
+        CODEC codec;
+        bool chunked;
+        bool filter;
+        bool packVertices;
+        bool interleave;
+        bool quantizeBones;
+        bool optimize;
+        bool reduceKeys;
+        KeyReduction reduction;
+        bool generateLods;
+        LodSettings lods;
+        bool buildMeshlets;
+        MeshletSettings meshlets;
+        std::string cacheDir;       // empty: no conversion cache
+        std::uint64_t cacheBytes;
+
+        BatchOptions()
+            : workers(0), threads(1), codec(CODEC::LZ4), chunked(false), filter(true), packVertices(false),
+              interleave(false), quantizeBones(false), optimize(false), reduceKeys(false), generateLods(false), buildMeshlets(false), cacheBytes(1ULL << 30) {}
+    };
+
+    namespace batch {
+
+        inline std::string basename(const std::string& path) {
+            const auto p = path.find_last_of("/\\");
+            return p == std::string::npos ? path : path.substr(p + 1);
+        }
+
+        inline std::string stem(const std::string& path) {
+            const auto name = basename(path);
+            const auto d = name.find_last_of('.');
+            return d == std::string::npos ? name : name.substr(0, d);
+        }
+
+        inline std::string dirname(const std::string& path) {
+            const auto p = path.find_last_of("/\\");
+            return p == std::string::npos ? std::string() : path.substr(0, p + 1);
+        }
+
+        inline std::uint64_t filesize(const std::string& path) {
+            std::ifstream ifs(path, std::ifstream::binary | std::ifstream::ate);
+            return ifs.is_open() ? static_cast<std::uint64_t>(ifs.tellg()) : 0;
+        }
+
+        inline std::string outputPath(const std::string& mesh, const std::string& outputDir) {
+            auto dir = outputDir.empty() ? dirname(mesh) : outputDir;
+            if(!dir.empty() && dir.back() != '/' && dir.back() != '\\') { dir += '/'; }
+            return dir + stem(mesh) + ".rkr";
+        }
+
+        /*
+         * "mesh.fbx[+anim.fbx...][=out.rkr]" -> job.
+         * output defaults to the mesh name with .rkr in outputDir.
+         */
+        inline ConvertJob parseJob(const std::string& spec, const std::string& outputDir) {
+            ConvertJob job;
+            auto files = spec;
+            const auto eq = spec.find('=');
+            if(eq != std::string::npos) {
+                files = spec.substr(0, eq);
+                job.output = spec.substr(eq + 1);
+            }
+            std::stringstream ss(files);
+            std::string f;
+            while(std::getline(ss, f, '+')) {
+                if(f.empty()) { continue; }
+                if(job.mesh.empty()) { job.mesh = f; } else { job.animes.push_back(f); }
+            }
+            if(job.output.empty() && !job.mesh.empty()) { job.output = outputPath(job.mesh, outputDir); }
+            return job;
+        }
+
+        /*
+         * manifest: one job per line, "mesh.fbx [anim.fbx ...] [> out.rkr]",
+         * '#' starts a comment. relative paths are taken from the manifest's directory.
+         */
+        inline bool loadManifest(const std::string& path, const std::string& outputDir, std::vector<ConvertJob>& jobs) {
+            std::ifstream ifs(path);
+            if(!ifs.is_open()) {
+                logger::error("[Batch] cannot open manifest ", path);
+                return false;
+            }
+            const auto base = dirname(path);
+            auto resolve = [&](const std::string& p) {
+                const auto absolute = !p.empty() && (p[0] == '/' || p[0] == '\\' || (p.size() > 1 && p[1] == ':'));
+                return absolute ? p : base + p;
+            };
+            std::string line;
+            while(std::getline(ifs, line)) {
+                const auto hash = line.find('#');
+                if(hash != std::string::npos) { line.resize(hash); }
+                std::stringstream ss(line);
+                ConvertJob job;
+                std::string token;
+                bool output = false;
+                while(ss >> token) {
+                    if(token == ">") { output = true; continue; }
+                    if(output) { job.output = resolve(token); output = false; }
+                    else if(job.mesh.empty()) { job.mesh = resolve(token); }
+                    else { job.animes.push_back(resolve(token)); }
+                }
+                if(job.mesh.empty()) { continue; }
+                if(job.output.empty()) { job.output = outputPath(job.mesh, outputDir); }
+                jobs.push_back(std::move(job));
+            }
+            return true;
+        }
+
+        /*
+         * attach "<stem>_<clip>.fbx" to "<stem>.fbx" when both are jobs of their own,
+         * the unitychan.fbx / unitychan_WAIT04.fbx layout. the longest stem wins.
+         */
+        inline void groupByName(std::vector<ConvertJob>& jobs) {
+            std::vector<bool> merged(jobs.size(), false);
+            for(std::size_t i = 0; i < jobs.size(); i++) {
+                if(!jobs[i].animes.empty()) { continue; }
+                const auto name = stem(jobs[i].mesh);
+                std::size_t owner = jobs.size(), best = 0;
+                for(std::size_t k = 0; k < jobs.size(); k++) {
+                    const auto s = stem(jobs[k].mesh);
+                    if(k == i || merged[k] || s.size() <= best || name.size() <= s.size() + 1) { continue; }
+                    if(dirname(jobs[k].mesh) == dirname(jobs[i].mesh) && name.compare(0, s.size(), s) == 0 && name[s.size()] == '_') {
+                        owner = k;
+                        best = s.size();
+                    }
+                }
+                if(owner < jobs.size()) {
+                    jobs[owner].animes.push_back(jobs[i].mesh);
+                    merged[i] = true;
+                }
+            }
+            std::size_t n = 0;
+            for(std::size_t i = 0; i < jobs.size(); i++) {
+                if(!merged[i]) { jobs[n++] = std::move(jobs[i]); }
+            }
+            jobs.resize(n);
+        }
+
+    } // namespace batch
+
+    /*
+     * converts jobs on a bounded pool of workers.
+     * every job gets its own FBXImporter (and so its own FbxManager per file).
+     */
+    class BatchConverter : private util::Noncopyable {
+    private:
+        BatchOptions options_;
+        std::mutex report_;
+        std::unique_ptr<ConversionCache> cache_;
+
+        // everything in options_ that changes the bytes of an output
+        std::uint64_t settings() const {
+            using OPTION = FBXImporter::OPTION;
+            const auto post = options_.optimize ? OPTION::OPTIMIZE_VERTEX_CACHE | OPTION::OPTIMIZE_OVERDRAW : 0;
+            std::uint64_t mask = static_cast<std::uint64_t>(OPTION::LOAD_ALL | post);
+            mask |= static_cast<std::uint64_t>(options_.codec) << 8;
+            mask |= (options_.chunked ? 1ULL : 0ULL) << 16;
+            mask |= (options_.filter ? 1ULL : 0ULL) << 17;
+            mask |= (options_.packVertices ? 1ULL : 0ULL) << 18;
+            mask |= (options_.interleave ? 1ULL : 0ULL) << 19;
+            mask |= (options_.quantizeBones ? 1ULL : 0ULL) << 20;
+            mask |= (options_.reduceKeys ? 1ULL : 0ULL) << 21;
+            if(options_.reduceKeys) {
+                const auto& r = options_.reduction;
+                const float tolerances[] = { r.position, r.rotation, r.scale };
+                mask ^= util::xxh64(tolerances, sizeof(tolerances)) & ~0xffffffULL;
+            }
+            mask |= (options_.generateLods ? 1ULL : 0ULL) << 22;
+            if(options_.generateLods) {
+                const auto& l = options_.lods;
+                std::vector<float> values(l.ratios);
+                values.push_back(l.maxError);
+                values.push_back(l.weightScale);
+                mask ^= util::xxh64(values.data(), values.size() * sizeof(float)) & ~0xffffffULL;
+            }
+            mask |= (options_.buildMeshlets ? 1ULL : 0ULL) << 23;
+            if(options_.buildMeshlets) {
+                const auto& m = options_.meshlets;
+                const float values[] = { static_cast<float>(m.maxVertices), static_cast<float>(m.maxTriangles), m.coneWeight };
+                mask ^= util::xxh64(values, sizeof(values)) & ~0xffffffULL;
+            }
+            return mask;
+        }
+
+        ConvertResult convert(const ConvertJob& job) {
+            using OPTION = FBXImporter::OPTION;
+            RECHOR_TRACE_SCOPE("convert");
+            RECHOR_TRACE_ARG("files", job.animes.size() + 1);
+            const auto begin = std::chrono::steady_clock::now();
+            ConvertResult result = { false, batch::filesize(job.mesh), 0, 0.0, false };
+
+            std::string key;
+            if(cache_) {
+                std::vector<std::string> inputs(1, job.mesh);
+                inputs.insert(inputs.end(), job.animes.begin(), job.animes.end());
+                RECHOR_TRACE_SCOPE("cache lookup");
+                key = ConversionCache::key(inputs, settings());
+                if(!key.empty() && cache_->fetch(key, job.output)) {
+                    for(auto&& a : job.animes) { result.inputBytes += batch::filesize(a); }
+                    result.ok = result.cached = true;
+                    result.outputBytes = batch::filesize(job.output);
+                    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+                    return result;
+                }
+            }
+
+            FBXImporter importer;
+            importer.setThreads(options_.threads);
+            if(options_.reduceKeys) { importer.setKeyReduction(options_.reduction); }
+            if(options_.generateLods) { importer.setLodGeneration(options_.lods); }
+            if(options_.buildMeshlets) { importer.setMeshletGeneration(options_.meshlets); }
+            const auto post = options_.optimize ? OPTION::OPTIMIZE_VERTEX_CACHE | OPTION::OPTIMIZE_OVERDRAW : 0;
+
+            Scene scene;
+            bool ok;
+            if(job.animes.empty()) {
+                ok = importer.load(job.mesh.c_str(), scene, OPTION::LOAD_ALL | post);
+            } else {
+                /* mesh first, then every clip is baked against it; the last load processes the scene */
+                ok = importer.load(job.mesh.c_str(), OPTION::LOAD_MESH | OPTION::LOAD_BONEWEIGHT);
+                for(std::size_t i = 0; ok && i < job.animes.size(); i++) {
+                    result.inputBytes += batch::filesize(job.animes[i]);
+                    if(i + 1 < job.animes.size()) {
+                        ok = importer.load(job.animes[i].c_str(), OPTION::LOAD_ANIM);
+                    } else {
+                        ok = importer.load(job.animes[i].c_str(), scene, OPTION::LOAD_ANIM | post);
+                    }
+                }
+            }
+
+            if(ok) {
+                Exporter exporter;
+                exporter.setCodec(options_.codec);
+                exporter.setChunked(options_.chunked);
+                exporter.setFilter(options_.filter);
+                exporter.setPackVertices(options_.packVertices);
+                exporter.setInterleave(options_.interleave);
+                exporter.setQuantizeBones(options_.quantizeBones);
+                exporter.setThreads(options_.threads);
+                ok = exporter.save(job.output.c_str(), scene);
+            }
+            if(ok && !key.empty()) { cache_->store(key, job.output); }
+
+            result.ok = ok;
+            result.outputBytes = ok ? batch::filesize(job.output) : 0;
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            return result;
+        }
+
+        static std::string megabytes(std::uint64_t bytes) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.2f MB", bytes / (1024.0 * 1024.0));
+            return buf;
+        }
+
+    public:
+        explicit BatchConverter(const BatchOptions& options) : options_(options) {
+            if(!options_.cacheDir.empty()) { cache_.reset(new ConversionCache(options_.cacheDir, options_.cacheBytes)); }
+        }
+
+        // returns the number of failed jobs
+        std::size_t run(const std::vector<ConvertJob>& jobs) {
+            const auto begin = std::chrono::steady_clock::now();
+            std::atomic<std::size_t> done(0), failed(0);
+            std::atomic<std::uint64_t> inputBytes(0), outputBytes(0);
+
+            util::parallel_for(jobs.size(), options_.workers, [&](std::size_t i) {
+                const auto r = convert(jobs[i]);
+                inputBytes += r.inputBytes;
+                outputBytes += r.outputBytes;
+                if(!r.ok) { failed++; }
+
+                char rate[32];
+                std::snprintf(rate, sizeof(rate), "%.1f", r.seconds > 0.0 ? r.inputBytes / (1024.0 * 1024.0) / r.seconds : 0.0);
+                std::lock_guard<std::mutex> lock(report_);
+                const auto n = ++done;
+                if(r.ok) {
+                    logger::log("[", n, "/", jobs.size(), "] ", jobName(jobs[i]), " -> ", jobs[i].output, "  ",
+                        megabytes(r.inputBytes), " -> ", megabytes(r.outputBytes), "  ", r.seconds, " s  ", rate, " MB/s",
+                        r.cached ? "  (cached)" : "");
+                } else {
+                    logger::error("[", n, "/", jobs.size(), "] ", jobName(jobs[i]), " failed");
+                }
+            });
+
+            const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            char rate[32];
+            std::snprintf(rate, sizeof(rate), "%.1f", seconds > 0.0 ? inputBytes / (1024.0 * 1024.0) / seconds : 0.0);
+            logger::log(jobs.size() - failed, " converted, ", failed.load(), " failed, ",
+                megabytes(inputBytes), " -> ", megabytes(outputBytes), " in ", seconds, " s (", rate, " MB/s)");
+            if(cache_) {
+                cache_->flush();
+                char hit[32];
+                std::snprintf(hit, sizeof(hit), "%.1f%%", cache_->hitRate() * 100.f);
+                logger::log("cache: ", cache_->hits(), " hits, ", cache_->misses(), " misses (", hit, "), ",
+                    cache_->count(), " entries, ", megabytes(cache_->size()));
+            }
+            return failed;
+        }
+
+        static std::string jobName(const ConvertJob& job) {
+            auto name = job.mesh;
+            for(auto&& a : job.animes) { name += "+" + batch::basename(a); }
+            return name;
+        }
+    };
+
+}} // namespace rhakt::rechor
+
+#endif
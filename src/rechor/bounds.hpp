@@ -0,0 +1,204 @@
+// rechor project
+// bounds.hpp
+//
+// bounding volumes for culling: a box and sphere around the bind pose of a
+// mesh, and boxes around the mesh as deformed by each baked frame.
+
+#ifndef _RHACT_RECHOR_BOUNDS_HPP_
+#define _RHACT_RECHOR_BOUNDS_HPP_
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "rechor.hpp"
+#include "keyframe_reducer.hpp"
+#include "skinning.hpp"
+#include "../parallel.hpp"
+
+namespace rhakt {
+namespace rechor {
+namespace bounds {
+
+    namespace detail {
+
+        // position i of mesh, from the float stream or the FLOAT3 position of the blob
+        template <typename S>
+        struct Positions {
+            const float* stream;
+            const uchar* blob;
+            std::size_t stride;
+            std::size_t count;
+
+            explicit Positions(const BasicMesh<S>& m) : stream(nullptr), blob(nullptr), stride(0), count(0) {
+                if(!m.vertices.empty()) {
+                    stream = m.vertices.data();
+                    count = m.vertices.size() / 3;
+                    return;
+                }
+                for(auto&& a : m.layout.attributes) {
+                    if(a.semantic == VERTEX_SEMANTIC::POSITION && a.format == VERTEX_FORMAT::FLOAT3 && m.layout.stride > 0) {
+                        blob = m.vertexBlob.data() + a.offset;
+                        stride = m.layout.stride;
+                        count = m.vertexBlob.size() / stride;
+                    }
+                }
+            }
+
+            void get(std::size_t i, float* p) const {
+                if(stream) {
+                    std::copy(stream + i * 3, stream + i * 3 + 3, p);
+                } else {
+                    std::memcpy(p, blob + i * stride, 3 * sizeof(float));
+                }
+            }
+        };
+
+        // box around b transformed by the row-vector matrix m (Arvo)
+        inline Aabb transform(const Aabb& b, const float* m) {
+            Aabb r;
+            if(b.empty()) { return r; }
+            for(int j = 0; j < 3; j++) {
+                r.min[j] = r.max[j] = m[12 + j];
+                for(int i = 0; i < 3; i++) {
+                    const auto lo = b.min[i] * m[i * 4 + j], hi = b.max[i] * m[i * 4 + j];
+                    r.min[j] += std::min(lo, hi);
+                    r.max[j] += std::max(lo, hi);
+                }
+            }
+            return r;
+        }
+
+        template <typename S>
+        bool skinnable(const BasicMesh<S>& m) {
+            const auto vc = m.vertices.size() / 3;
+            return vc > 0 && m.boneIndices.size() == vc * skinning::INFLUENCES && m.boneWeights.size() == vc * skinning::INFLUENCES;
+        }
+
+    } // namespace detail
+
+    /* box around the bind pose (vertex streams, or the FLOAT3 positions of an interleaved blob) */
+    template <typename S>
+    inline Aabb computeAabb(const BasicMesh<S>& mesh) {
+        const detail::Positions<S> pos(mesh);
+        Aabb b;
+        for(std::size_t i = 0; i < pos.count; i++) {
+            float p[3];
+            pos.get(i, p);
+            b.extend(p);
+        }
+        return b;
+    }
+
+    // centered on the box, radius to the farthest vertex
+    template <typename S>
+    inline Sphere computeSphere(const BasicMesh<S>& mesh, const Aabb& box) {
+        Sphere s;
+        if(box.empty()) { return s; }
+        const detail::Positions<S> pos(mesh);
+        float r2 = 0.f;
+        for(int k = 0; k < 3; k++) { s.center[k] = (box.min[k] + box.max[k]) * 0.5f; }
+        for(std::size_t i = 0; i < pos.count; i++) {
+            float p[3];
+            pos.get(i, p);
+            const auto dx = p[0] - s.center[0], dy = p[1] - s.center[1], dz = p[2] - s.center[2];
+            r2 = std::max(r2, dx * dx + dy * dy + dz * dz);
+        }
+        s.radius = std::sqrt(r2);
+        return s;
+    }
+
+    /*
+     * box of mesh per frame of af, and their union. skinned meshes are skinned
+     * with the frame's bone palette (baked or decoded from keys), others take
+     * the bind pose box through the mesh matrix. frames stays empty when af has
+     * bones but the mesh has no bone streams (interleaved) or af has no frames
+     * or a bone track narrower than one matrix.
+     * bindBox is computeAabb(mesh). palette is scratch for decoded bone keys,
+     * owned by the caller so it can be kept across calls.
+     */
+    template <typename S, typename T, typename V>
+    inline void computeAnimBounds(const BasicMesh<S>& mesh, const Aabb& bindBox, const BasicAnimFrame<T>& af, Aabb& clip, V& frames, std::vector<float>& palette) {
+        clip = Aabb();
+        frames.clear();
+        const auto animBones = af.reduced() ? !af.boneKeys.empty() : !af.boneMatrices.empty();
+        const std::size_t bc = af.reduced() ? af.boneKeys.size() : af.boneMatrices.stride / 16;
+        const auto skinned = animBones && bc > 0 && detail::skinnable(mesh);
+        if(animBones && !skinned) { return; }
+
+        const std::size_t fc = af.reduced() ? af.frameCount : std::max(af.meshMatrices.frameCount, af.boneMatrices.frameCount);
+        if(fc == 0 || bindBox.empty()) { return; }
+        frames.resize(fc);
+
+        if(skinned) {
+            const auto vc = mesh.vertices.size() / 3;
+            palette.resize(bc * 16);
+            const skinning::Job job = {
+                mesh.vertices.data(), nullptr, mesh.boneIndices.data(), mesh.boneWeights.data(),
+                nullptr, bc, nullptr, nullptr
+            };
+            for(std::size_t f = 0; f < fc; f++) {
+                const float* pal;
+                if(af.reduced()) {
+                    for(std::size_t b = 0; b < bc; b++) {
+                        const auto& k = af.boneKeys[b];
+                        keyframe::decodeTrack(k.frames.data(), k.keys.data(), k.frames.size(), static_cast<float>(f), &palette[b * 16]);
+                    }
+                    pal = palette.data();
+                } else {
+                    pal = af.boneMatrices.frame(std::min<std::size_t>(f, af.boneMatrices.frameCount - 1));
+                }
+                auto fj = job;
+                fj.palette = pal;
+                Aabb box;
+                skinning::skinBounds(fj, 0, vc, box);
+                frames[f] = box;
+                clip.extend(box);
+            }
+            return;
+        }
+
+        for(std::size_t f = 0; f < fc; f++) {
+            float m[16];
+            if(af.reduced() && !af.meshKeys.frames.empty()) {
+                keyframe::decodeTrack(af.meshKeys.frames.data(), af.meshKeys.keys.data(), af.meshKeys.frames.size(), static_cast<float>(f), m);
+                frames[f] = detail::transform(bindBox, m);
+            } else if(!af.meshMatrices.empty()) {
+                frames[f] = detail::transform(bindBox, af.meshMatrices.frame(std::min<std::size_t>(f, af.meshMatrices.frameCount - 1)));
+            } else {
+                frames[f] = bindBox;
+            }
+            clip.extend(frames[f]);
+        }
+    }
+
+    /* fills Mesh::bounds/sphere and AnimFrame::bounds/frameBounds of the whole scene */
+    template <typename S>
+    inline void computeBounds(BasicScene<S>& scene, uint threads = 1) {
+        util::parallel_for(scene.meshes.size(), threads, [&](std::size_t i) {
+            auto& m = scene.meshes[i];
+            m.bounds = computeAabb(m);
+            m.sphere = computeSphere(m, m.bounds);
+        });
+        // one job per animated mesh
+        std::vector<std::pair<std::size_t, std::size_t>> jobs;
+        for(std::size_t a = 0; a < scene.animes.size(); a++) {
+            for(std::size_t k = 0; k < scene.animes[a].meshes.size(); k++) { jobs.emplace_back(a, k); }
+        }
+        std::vector<std::vector<float>> palettes(jobs.size());
+        util::parallel_for(jobs.size(), threads, [&](std::size_t j) {
+            auto& af = scene.animes[jobs[j].first].meshes[jobs[j].second];
+            if(jobs[j].second < scene.meshes.size()) {
+                const auto& m = scene.meshes[jobs[j].second];
+                computeAnimBounds(m, m.bounds, af, af.bounds, af.frameBounds, palettes[j]);
+            } else {
+                af.bounds = Aabb();
+                af.frameBounds.clear();
+            }
+        });
+    }
+
+}}} // namespace rhakt::rechor::bounds
+
+#endif
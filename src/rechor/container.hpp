@@ -0,0 +1,121 @@
+// rechor project
+// container.hpp
+
+#ifndef _RHACT_RECHOR_CONTAINER_HPP_
+#define _RHACT_RECHOR_CONTAINER_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+#include "rechor.hpp"
+#include "../xxhash.hpp"
+
+namespace rhakt {
+namespace rechor {
+
+    // 1: single payload, 2: chunked payload, 3: filtered streams, 4: flat animation tracks
+    static const std::uint16_t FORMAT_VERSION = 4;
+
+    /*
+     * fixed header in front of the .rkr payload (little endian, 32 bytes)
+     * files without it are legacy: headerless LZ4 or a plain flatbuffer
+     */
+    struct FileHeader {
+        char magic[4];              // "RKR\x1a"
+        std::uint16_t version;      // FORMAT_VERSION
+        std::uint8_t codec;         // CODEC
+        std::uint8_t flags;         // container::FLAG_*
+        std::uint64_t rawSize;      // decoded payload size (chunked: sum of decoded blocks)
+        std::uint64_t payloadSize;  // stored payload size
+        std::uint64_t checksum;     // XXH64 of stored payload (chunked: of the directory)
+    };
+    static_assert(sizeof(FileHeader) == 32, "unexpected FileHeader padding");
+
+    enum struct CHUNK_KIND : std::uint8_t {
+        MESH = 0,   // root is model::Mesh
+        ANIM = 1    // root is model::Anim
+    };
+
+    /*
+     * chunked payload:
+     *   uint32 meshCount, uint32 animCount,
+     *   ChunkEntry[meshCount + animCount] (meshes first, by index),
+     *   blocks, each one an independent flatbuffer
+     */
+    struct ChunkEntry {
+        std::uint8_t kind;          // CHUNK_KIND
+        std::uint8_t codec;         // CODEC
+        std::uint16_t reserved;
+        std::uint32_t index;        // mesh or anim index
+        std::uint64_t offset;       // from the start of the payload
+        std::uint64_t size;         // stored size
+        std::uint64_t rawSize;      // decoded size
+        std::uint64_t checksum;     // XXH64 of the stored block
+    };
+    static_assert(sizeof(ChunkEntry) == 40, "unexpected ChunkEntry padding");
+
+    namespace container {
+
+        static const char MAGIC[4] = { 'R', 'K', 'R', '\x1a' };
+
+        static const std::uint8_t FLAG_CHUNKED = 0x01;
+        static const std::uint8_t FLAG_FILTERED = 0x02;    // LZ4 payloads hold filter::StreamFilter output
+
+        // blocks start 16 byte aligned so mapped flatbuffers stay aligned
+        static const std::size_t BLOCK_ALIGN = 16;
+
+        inline std::size_t alignBlock(std::size_t offset) {
+            return (offset + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1);
+        }
+
+        inline std::size_t directorySize(std::size_t entries) {
+            return sizeof(std::uint32_t) * 2 + entries * sizeof(ChunkEntry);
+        }
+
+        inline FileHeader makeHeader(CODEC codec, std::size_t rawSize, const char* payload, std::size_t payloadSize) {
+            FileHeader h;
+            std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+            h.version = FORMAT_VERSION;
+            h.codec = static_cast<std::uint8_t>(codec);
+            h.flags = 0;
+            h.rawSize = rawSize;
+            h.payloadSize = payloadSize;
+            h.checksum = util::xxh64(payload, payloadSize);
+            return h;
+        }
+
+        inline bool hasHeader(const char* data, std::size_t size) {
+            return size >= sizeof(FileHeader) && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+        }
+
+        // returns false if the header is inconsistent with the file
+        inline bool readHeader(const char* data, std::size_t size, FileHeader& h) {
+            std::memcpy(&h, data, sizeof(FileHeader));
+            if(h.version > FORMAT_VERSION) {
+                logger::error("[RKR] unsupported version ", h.version);
+                return false;
+            }
+            if(h.codec > static_cast<std::uint8_t>(CODEC::LZ4)) {
+                logger::error("[RKR] unknown codec ", static_cast<int>(h.codec));
+                return false;
+            }
+            if(h.payloadSize != size - sizeof(FileHeader)) {
+                logger::error("[RKR] truncated file");
+                return false;
+            }
+            return true;
+        }
+
+        inline bool checkPayload(const FileHeader& h, const char* payload, std::size_t size) {
+            if(util::xxh64(payload, size) != h.checksum) {
+                logger::error("[RKR] checksum mismatch");
+                return false;
+            }
+            return true;
+        }
+
+    } // namespace container
+
+}} // namespace rhakt::rechor
+
+#endif
@@ -0,0 +1,202 @@
+// rechor project
+// conversion_cache.hpp
+//
+// content-addressed store of finished .rkr files.
+// key: XXH64 of the input FBX bytes, the conversion settings, FORMAT_VERSION and OUTPUT_REVISION.
+
+#ifndef _RHACT_RECHOR_CONVERSION_CACHE_HPP_
+#define _RHACT_RECHOR_CONVERSION_CACHE_HPP_
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+#include <cstdint>
+#include <cstdio>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "rechor.hpp"
+#include "container.hpp"
+#include "../util.hpp"
+#include "../xxhash.hpp"
+#include "../logger.hpp"
+
+namespace rhakt {
+namespace rechor {
+
+    /*
+     * bumped whenever the same inputs and settings convert to different bytes
+     * without a new FORMAT_VERSION, so older cache entries stop matching.
+     * 1: bounds written on every save
+     * 2: full precision bones for non-uniform scale under --quantize-bones
+     * 3: positional LOD error, without the bone weight penalty
+     */
+    static const std::uint64_t OUTPUT_REVISION = 3;
+
+    /*
+     * <dir>/<key>.rkr holds the output, <dir>/index one "key size tick" line per entry.
+     * tick is the last use; the least recently used entries go first once the cache
+     * is over maxBytes. safe to share between the workers of one process.
+     */
+    class ConversionCache : private util::Noncopyable {
+    private:
+        struct Entry {
+            std::uint64_t size;
+            std::uint64_t tick;
+        };
+
+        std::string dir_;
+        std::uint64_t maxBytes_;
+        std::unordered_map<std::string, Entry> entries_;
+        std::uint64_t total_;
+        std::uint64_t tick_;
+        std::size_t hits_;
+        std::size_t misses_;
+        bool dirty_;
+        std::mutex mutex_;
+
+        std::string path(const std::string& key) const { return dir_ + key + ".rkr"; }
+
+        static bool makedir(const std::string& dir) {
+#ifdef _WIN32
+            return ::_mkdir(dir.c_str()) == 0 || errno == EEXIST;
+#else
+            return ::mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+        }
+
+        void loadIndex() {
+            std::ifstream ifs(dir_ + "index");
+            std::string key;
+            Entry e;
+            while(ifs >> key >> e.size >> e.tick) {
+                entries_[key] = e;
+                total_ += e.size;
+                tick_ = std::max(tick_, e.tick + 1);
+            }
+        }
+
+        // drops least recently used entries until the cache fits (mutex held)
+        void evict() {
+            if(total_ <= maxBytes_) { return; }
+            std::vector<std::pair<std::uint64_t, std::string>> order;
+            order.reserve(entries_.size());
+            for(auto&& e : entries_) { order.emplace_back(e.second.tick, e.first); }
+            std::sort(order.begin(), order.end());
+            for(auto&& o : order) {
+                if(total_ <= maxBytes_) { break; }
+                total_ -= entries_[o.second].size;
+                entries_.erase(o.second);
+                std::remove(path(o.second).c_str());
+                logger::debug("[Cache] evict ", o.second);
+            }
+            dirty_ = true;
+        }
+
+    public:
+        explicit ConversionCache(const std::string& dir, std::uint64_t maxBytes = 1ULL << 30)
+            : dir_(dir), maxBytes_(maxBytes), total_(0), tick_(1), hits_(0), misses_(0), dirty_(false) {
+            if(!dir_.empty() && dir_.back() != '/' && dir_.back() != '\\') { dir_ += '/'; }
+            if(!makedir(dir_)) { logger::warn("[Cache] cannot create ", dir_); }
+            loadIndex();
+        }
+
+        ~ConversionCache() { flush(); }
+
+        /*
+         * key of converting inputs (in order) with settings; empty when an input is unreadable.
+         * settings is any mask of the options that change the output.
+         */
+        static std::string key(const std::vector<std::string>& inputs, std::uint64_t settings) {
+            util::XXH64 h;
+            const std::uint64_t version = FORMAT_VERSION;
+            h.update(&version, sizeof(version));
+            h.update(&OUTPUT_REVISION, sizeof(OUTPUT_REVISION));
+            h.update(&settings, sizeof(settings));
+            for(auto&& input : inputs) {
+                util::MappedFile file;
+                if(!file.open(input)) { return std::string(); }
+                const std::uint64_t size = file.size();
+                h.update(&size, sizeof(size));
+                h.update(file.data(), file.size());
+            }
+            char buf[17];
+            std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(h.digest()));
+            return buf;
+        }
+
+        // on a hit, copies the cached file to output
+        bool fetch(const std::string& key, const std::string& output) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if(it == entries_.end()) {
+                misses_++;
+                return false;
+            }
+            it->second.tick = tick_++;
+            const auto size = it->second.size;
+            dirty_ = true;
+            lock.unlock();
+
+            std::string buf;
+            if(util::loadfile(path(key), true, buf) && buf.size() == size && util::savefile(output, true, buf)) {
+                lock.lock();
+                hits_++;
+                return true;
+            }
+            // removed behind our back (or the output is not writable): convert again
+            lock.lock();
+            misses_++;
+            it = entries_.find(key);
+            if(it != entries_.end()) {
+                total_ -= it->second.size;
+                entries_.erase(it);
+            }
+            return false;
+        }
+
+        // stores a freshly written output under key
+        bool store(const std::string& key, const std::string& output) {
+            std::string buf;
+            if(!util::loadfile(output, true, buf) || !util::savefile(path(key), true, buf)) {
+                logger::warn("[Cache] cannot store ", output);
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& e = entries_[key];
+            total_ = total_ - e.size + buf.size();
+            e.size = buf.size();
+            e.tick = tick_++;
+            dirty_ = true;
+            evict();
+            return true;
+        }
+
+        // writes the index back
+        void flush() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(!dirty_) { return; }
+            std::ofstream ofs(dir_ + "index", std::ofstream::trunc);
+            for(auto&& e : entries_) { ofs << e.first << ' ' << e.second.size << ' ' << e.second.tick << '\n'; }
+            dirty_ = false;
+        }
+
+        std::size_t hits() const { return hits_; }
+        std::size_t misses() const { return misses_; }
+        float hitRate() const {
+            const auto n = hits_ + misses_;
+            return n ? static_cast<float>(hits_) / n : 0.f;
+        }
+        std::uint64_t size() const { return total_; }
+        std::size_t count() const { return entries_.size(); }
+    };
+
+}} // namespace rhakt::rechor
+
+#endif
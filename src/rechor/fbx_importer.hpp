@@ -16,21 +16,20 @@
 #include <fbxsdk.h>
 
 #include "rechor.hpp"
+#include "vertex_welder.hpp"
+#include "keyframe_reducer.hpp"
+#include "mesh_optimizer.hpp"
+#include "simplifier.hpp"
+#include "meshlet.hpp"
+#include "../parallel.hpp"
+#include "../trace.hpp"
 
 namespace rhakt {
 namespace rechor {
 
-    typedef std::array<float, 3> vertex_t;
-    typedef std::array<float, 3> normal_t;
-    typedef std::array<float, 4> color_t;
-    typedef std::array<float, 2> uv_t;
-    typedef std::array<uint,  4> bindex_t;
-    typedef std::array<float, 4> bweight_t;
-    typedef std::tuple<vertex_t, normal_t, color_t, uv_t, bindex_t, bweight_t> element_t;
-    
     struct AnimFrameRaw {
-        std::vector<std::vector<float>> meshMatrices;
-        std::vector<std::vector<float>> boneMatrices;
+        Track meshMatrices;
+        Track boneMatrices;
     };
 
     struct AnimRaw {
@@ -74,6 +73,8 @@ namespace rechor {
             static const FBX_IMPORTER_OPTION LOAD_BONEWEIGHT = 0x04;
             static const FBX_IMPORTER_OPTION LOAD_ANIM      = 0x08;
             static const FBX_IMPORTER_OPTION LOAD_ALL       = 0x0f;
+            static const FBX_IMPORTER_OPTION OPTIMIZE_VERTEX_CACHE = 0x10; // triangle order + vertex fetch order
+            static const FBX_IMPORTER_OPTION OPTIMIZE_OVERDRAW     = 0x20; // with OPTIMIZE_VERTEX_CACHE
         };
 
     private:
@@ -86,54 +87,17 @@ namespace rechor {
         
         SceneRaw rscene_;
 
+        uint threads_;
+        bool reduce_;
+        KeyReduction reduction_;
+        bool lods_;
+        LodSettings lodSettings_;
+        bool meshlets_;
+        MeshletSettings meshletSettings_;
+
         
         Mesh processMesh(const MeshRaw& src) {
-            Mesh dst;
-            std::vector<element_t> cache;
-            cache.reserve(src.indices.size());
-
-            dst.vertices.reserve(src.indices.size() * std::tuple_size<vertex_t>::value);
-            dst.normals.reserve(src.indices.size() * std::tuple_size<normal_t>::value);
-            dst.colors.reserve(src.indices.size() * std::tuple_size<color_t>::value);
-            dst.uvs.reserve(src.indices.size() * std::tuple_size<uv_t>::value);
-            dst.indices.reserve(src.indices.size());
-            dst.boneIndices.reserve(src.indices.size() * std::tuple_size<bindex_t>::value);
-            dst.boneWeights.reserve(src.indices.size() * std::tuple_size<bweight_t>::value);
-            
-            /* indexify */
-            for (auto i = 0U; i < src.indices.size(); i++) {
-                const auto& ver = src.vertices[i];
-                const auto& nor = src.normals[i];
-                const auto& uv = src.uvs[i];
-                const auto& col = src.colors.empty() ? util::make_array<float>(1.f, 1.f, 1.f, 1.f) : src.colors[i];
-                const auto& bi = src.boneIndices.empty() ? util::make_array<uint>(0U, 0U, 0U, 0U) : src.boneIndices[i];
-                const auto& bw = src.boneWeights.empty() ? util::make_array<float>(0.f, 0.f, 0.f, 0.f) : src.boneWeights[i];
-                
-                auto it = std::find(
-                    cache.begin(), 
-                    cache.end(), 
-                    std::make_tuple(ver, nor, col, uv, bi, bw)
-                );
-                if(it == cache.end()) {
-                    /* not found */
-                    for(auto&& v : ver) { dst.vertices.push_back(v); }
-                    for(auto&& v : nor) { dst.normals.push_back(v); }
-                    for(auto&& v : col) { dst.colors.push_back(v); }
-                    for(auto&& v : uv) { dst.uvs.push_back(v); }
-                    if(src.boneIndices.size()) {
-                        for(auto&& v : bi) { dst.boneIndices.push_back(v); }
-                    }
-                    if(src.boneWeights.size()) {
-                        for(auto&& v : bw) { dst.boneWeights.push_back(v); }
-                    }
-                    dst.indices.push_back(cache.size());
-                    cache.emplace_back(ver, nor, col, uv, bi, bw);
-                } else {
-                    /* found */
-                    const auto index = std::distance(cache.begin(), it);
-                    dst.indices.push_back(index);
-                }
-            }
+            auto dst = weldMesh(src);
             assert(dst.indices.size() % 3 == 0);
 
             dst.texture = std::move(src.texture);
@@ -147,18 +111,75 @@ namespace rechor {
             for(auto&& m : src.meshes) {
                 dst.meshes.push_back({std::move(m.meshMatrices), std::move(m.boneMatrices)});
             }
+            if(reduce_) {
+                reduceKeyframes(dst, reduction_, threads_);
+            }
             return std::move(dst);
         }
 
-        void processScene(Scene& dst, SceneRaw& src) {
-            dst.meshes.reserve(src.meshes.size());
+        // returns cache stats before and after
+        std::pair<meshopt::CacheStats, meshopt::CacheStats> optimizeMesh(Mesh& mesh, FBX_IMPORTER_OPTION option) {
+            const auto vc = mesh.vertices.size() / 3;
+            const auto before = meshopt::analyzeCache(mesh.indices, vc);
+            meshopt::optimizeVertexCache(mesh.indices, vc);
+            if(option & OPTION::OPTIMIZE_OVERDRAW) {
+                meshopt::optimizeOverdraw(mesh.indices, mesh.vertices);
+            }
+            meshopt::optimizeVertexFetch(mesh);
+            return std::make_pair(before, meshopt::analyzeCache(mesh.indices, vc));
+        }
+
+        void processScene(Scene& dst, SceneRaw& src, FBX_IMPORTER_OPTION option = OPTION::LOAD_ALL) {
+            const auto base = dst.meshes.size();
+            dst.meshes.resize(base + src.meshes.size());
             dst.animes.reserve(src.animes.size());
             logger::info("process mesh...");
-            for(auto&& src : src.meshes) {
-                dst.meshes.push_back(std::move(processMesh(src)));
+            const auto optimize = (option & OPTION::OPTIMIZE_VERTEX_CACHE) != 0;
+            std::vector<std::pair<meshopt::CacheStats, meshopt::CacheStats>> stats(optimize ? src.meshes.size() : 0);
+            util::parallel_for(src.meshes.size(), threads_, [&](std::size_t i) {
+                {
+                    RECHOR_TRACE_SCOPE("weld");
+                    RECHOR_TRACE_ARG("mesh", i);
+                    RECHOR_TRACE_ARG("polygon vertices", src.meshes[i].indices.size());
+                    dst.meshes[base + i] = processMesh(src.meshes[i]);
+                    RECHOR_TRACE_ARG("vertices", dst.meshes[base + i].vertices.size() / 3);
+                }
+                if(optimize) {
+                    RECHOR_TRACE_SCOPE("optimize mesh");
+                    RECHOR_TRACE_ARG("mesh", i);
+                    stats[i] = optimizeMesh(dst.meshes[base + i], option);
+                }
+                if(lods_) {
+                    RECHOR_TRACE_SCOPE("generate lods");
+                    RECHOR_TRACE_ARG("mesh", i);
+                    generateLods(dst.meshes[base + i], lodSettings_);
+                    RECHOR_TRACE_ARG("levels", dst.meshes[base + i].lods.size());
+                }
+                if(meshlets_) {
+                    RECHOR_TRACE_SCOPE("build meshlets");
+                    RECHOR_TRACE_ARG("mesh", i);
+                    buildMeshlets(dst.meshes[base + i], meshletSettings_);
+                    RECHOR_TRACE_ARG("meshlets", dst.meshes[base + i].meshlets.size());
+                }
+            });
+            for(auto i = 0U; i < stats.size(); i++) {
+                logger::info("mesh ", i, " ACMR ", stats[i].first.acmr, " -> ", stats[i].second.acmr,
+                    ", ATVR ", stats[i].first.atvr, " -> ", stats[i].second.atvr);
+            }
+            for(auto i = 0U; lods_ && i < src.meshes.size(); i++) {
+                for(auto&& l : dst.meshes[base + i].lods) {
+                    logger::info("mesh ", i, " lod ", l.indices.size() / 3, " triangles, error ", l.error);
+                }
+            }
+            for(auto i = 0U; meshlets_ && i < src.meshes.size(); i++) {
+                const auto& m = dst.meshes[base + i];
+                logger::info("mesh ", i, " ", m.meshlets.size(), " meshlets, ", m.meshletVertices.size(), " meshlet vertices");
             }
             logger::info("process anim...");
             for(auto&& src : src.animes) {
+                RECHOR_TRACE_SCOPE("process anim");
+                RECHOR_TRACE_ARG("meshes", src.meshes.size());
+                RECHOR_TRACE_ARG("frames", src.end - src.start);
                 dst.animes.push_back(std::move(processAnim(src)));
             }
         }
@@ -314,6 +335,31 @@ namespace rechor {
             }
         }
 
+        // bone names and base pose (uses the scene evaluator, not thread safe)
+        void parseBonePose(FbxMesh* const fbxmesh, MeshRaw& mesh) {
+
+            const auto sc = fbxmesh->GetDeformerCount(FbxDeformer::eSkin);
+            if(sc == 0) {
+                
+                return;
+            }
+            assert(sc <= 1);
+
+            const auto skin = static_cast<FbxSkin*>(fbxmesh->GetDeformer(0, FbxDeformer::eSkin));
+            for(int i = 0; i < skin->GetClusterCount(); i++){
+                const auto cluster = skin->GetCluster(i);
+                if(cluster->GetControlPointIndicesCount() == 0) { continue; }
+
+                // save BoneNodeName
+                mesh.boneNodeNames.push_back(cluster->GetLink()->GetName());
+
+                // invMatrix of BasePose
+                auto bbpm = cluster->GetLink()->EvaluateGlobalTransform().Inverse();
+                mesh.invBoneBasePoseMatrices.push_back(bbpm);
+            }
+        }
+
+        // bone weights per polygon vertex (reads the mesh only)
         void parseBoneWeight(FbxMesh* const fbxmesh, MeshRaw& mesh) {
             
             const auto sc = fbxmesh->GetDeformerCount(FbxDeformer::eSkin);
@@ -340,13 +386,6 @@ namespace rechor {
                 for(int k = 0; k < cpic; k++) {
                     boneWeights[indices[k]].emplace_back(cc, static_cast<float>(weights[k]));
                 }
-                
-                // save BoneNodeName
-                mesh.boneNodeNames.push_back(cluster->GetLink()->GetName());
-
-                // invMatrix of BasePose
-                auto bbpm = cluster->GetLink()->EvaluateGlobalTransform().Inverse();
-                mesh.invBoneBasePoseMatrices.push_back(bbpm);
 
                 cc++;
             }
@@ -387,69 +426,107 @@ namespace rechor {
         }
 
         void parseAnim(FbxScene* const fbxscene, const SceneRaw& scene, AnimRaw& anim) {
-            
-            anim.meshes.reserve(scene.meshes.size());
 
-            for(auto&& m : scene.meshes) {
-                AnimFrameRaw af;
-                
+            const auto first = anim.start + 1;
+            const auto fc = static_cast<std::size_t>(std::max(0, anim.end - 1 - first));
+
+            /* resolve nodes */
+            std::vector<FbxNode*> meshNodes(scene.meshes.size(), nullptr);
+            std::vector<std::vector<FbxNode*>> boneNodes(scene.meshes.size());
+            anim.meshes.resize(scene.meshes.size());
+            for(auto k = 0U; k < scene.meshes.size(); k++) {
+                const auto& m = scene.meshes[k];
+                auto& af = anim.meshes[k];
+
                 /* mesh matrix */
                 auto itmesh = this->nodemap.find(m.nodeName);
                 if(itmesh != this->nodemap.end()) {
-                    af.meshMatrices.reserve(anim.end - anim.start + 1);
-                    const auto meshNode = fbxscene->GetNode(itmesh->second);
-                    for(auto frame = anim.start + 1; frame < anim.end - 1; frame++) {
-                        FbxTime time;
-                        time.Set(FbxTime::GetOneFrameValue(FbxTime::eFrames60) * frame);
-
-                        const auto& meshMatrix = meshNode->EvaluateGlobalTransform(time);
-                        //auto matrixRaw = m.invMeshBasePoseMatrix * meshMatrix;  f*ck
-                        const auto matrixRaw = meshMatrix * m.invMeshBasePoseMatrix;
-                        std::vector<float> matrix(16);
-                        for(int i = 0; i < 16; i++) {
-                            matrix[i] = static_cast<float>(matrixRaw[i / 4][i % 4]);
-                        }
-                        af.meshMatrices.push_back(std::move(matrix));
-
-                    }
+                    meshNodes[k] = fbxscene->GetNode(itmesh->second);
+                    af.meshMatrices.resize(static_cast<uint>(fc), 16);
                 }
 
                 /* bone matrix */
                 if(!m.boneNodeNames.empty()) {
-                    std::vector<FbxNode*> boneNodes(m.boneNodeNames.size());
-                    std::transform(m.boneNodeNames.begin(), m.boneNodeNames.end(), boneNodes.begin(), [&](auto bn){
+                    boneNodes[k].resize(m.boneNodeNames.size());
+                    std::transform(m.boneNodeNames.begin(), m.boneNodeNames.end(), boneNodes[k].begin(), [&](auto bn){
                         auto it = this->nodemap.find(bn);
                         assert(it != this->nodemap.end());
                         return fbxscene->GetNode(it->second);
                     });
-                    af.boneMatrices.reserve((anim.end - anim.start + 1));
-                    
-                    for(auto frame = anim.start + 1; frame < anim.end - 1; frame++) {
-                        FbxTime time;
-                        time.Set(FbxTime::GetOneFrameValue(FbxTime::eFrames60) * frame);
-
-                        auto k = 0;
-                        std::vector<float> boneMatrices;
-                        boneMatrices.reserve(boneNodes.size());
-                        for(auto&& boneNode : boneNodes) {
-                            const auto& boneMatrix = boneNode->EvaluateGlobalTransform(time);
-                            //auto matrixRaw = m.invBoneBasePoseMatrices[k] * boneMatrix;
-                            const auto matrixRaw = (FbxMatrix)boneMatrix * m.invBoneBasePoseMatrices[k];
+                    af.boneMatrices.resize(static_cast<uint>(fc), static_cast<uint>(boneNodes[k].size() * 16));
+                }
+            }
+
+            /*
+             * contiguous frame ranges per worker.
+             * the scene evaluator caches results and is not thread safe,
+             * so every worker samples through an evaluator of its own.
+             * FBX SDK calls assumed thread safe (not documented by the SDK,
+             * checked by bench_import against the serial path):
+             * - FbxAnimEvaluator::GetNodeGlobalTransform on distinct
+             *   evaluators of one scene, which only read nodes and curves.
+             * - FbxTime and FbxAMatrix / FbxMatrix arithmetic on locals.
+             * everything else stays on this thread: evaluator Create and
+             * Destroy (they register with the scene), GetNode and the
+             * scene evaluator (serial path only).
+             */
+            const auto tc = std::max<std::size_t>(std::min<std::size_t>(util::resolve_threads(threads_), fc), 1);
+            std::vector<FbxAnimEvaluator*> evaluators;
+            if(tc > 1) {
+                for(auto t = 0U; t < tc; t++) {
+                    evaluators.push_back(FbxAnimEvalClassic::Create(fbxscene, ""));
+                }
+            }
+
+            util::parallel_for(tc, static_cast<uint>(tc), [&](std::size_t t) {
+                const auto evaluator = evaluators.empty() ? nullptr : evaluators[t];
+                auto evaluate = [&](FbxNode* node, const FbxTime& time) -> const FbxAMatrix& {
+                    return evaluator ? evaluator->GetNodeGlobalTransform(node, time) : node->EvaluateGlobalTransform(time);
+                };
+
+                for(auto f = fc * t / tc; f < fc * (t + 1) / tc; f++) {
+                    const auto frame = first + static_cast<int>(f);
+                    FbxTime time;
+                    time.Set(FbxTime::GetOneFrameValue(FbxTime::eFrames60) * frame);
+
+                    for(auto k = 0U; k < scene.meshes.size(); k++) {
+                        const auto& m = scene.meshes[k];
+                        auto& af = anim.meshes[k];
+
+                        if(meshNodes[k]) {
+                            const auto& meshMatrix = evaluate(meshNodes[k], time);
+                            //auto matrixRaw = m.invMeshBasePoseMatrix * meshMatrix;  f*ck
+                            const auto matrixRaw = meshMatrix * m.invMeshBasePoseMatrix;
+                            const auto matrix = af.meshMatrices.frame(f);
                             for(int i = 0; i < 16; i++) {
-                                boneMatrices.push_back(static_cast<float>(matrixRaw[i / 4][i % 4]));
+                                matrix[i] = static_cast<float>(matrixRaw[i / 4][i % 4]);
+                            }
+                        }
+
+                        if(!boneNodes[k].empty()) {
+                            auto b = 0;
+                            const auto boneMatrices = af.boneMatrices.frame(f);
+                            for(auto&& boneNode : boneNodes[k]) {
+                                const auto& boneMatrix = evaluate(boneNode, time);
+                                //auto matrixRaw = m.invBoneBasePoseMatrices[b] * boneMatrix;
+                                const auto matrixRaw = (FbxMatrix)boneMatrix * m.invBoneBasePoseMatrices[b];
+                                for(int i = 0; i < 16; i++) {
+                                    boneMatrices[b * 16 + i] = static_cast<float>(matrixRaw[i / 4][i % 4]);
+                                }
+                                b++;
                             }
-                            k++;
                         }
-                        af.boneMatrices.push_back(std::move(boneMatrices));
                     }
                 }
-                anim.meshes.push_back(std::move(af));
-            }
+            });
+
+            for(auto&& e : evaluators) { e->Destroy(); }
         }
 
         bool loadRaw(const char* const filename, SceneRaw& scene, FBX_IMPORTER_OPTION option = OPTION::LOAD_ALL) {
 
             logger::info("parse ", filename, " ...");
+            RECHOR_TRACE_SCOPE("FBXImporter::loadRaw");
 
             std::unique_ptr<FbxManager, fbx_deleter<FbxManager>> manager(FbxManager::Create());
 
@@ -465,19 +542,30 @@ namespace rechor {
             }
 
             std::unique_ptr<FbxScene, fbx_deleter<FbxScene>> fbxscene(FbxScene::Create(manager.get(), "Scene"));
-            if(!importer->Import(fbxscene.get())) {
-                logger::error("[FBX Importer] ", importer->GetStatus().GetErrorString());
-                return false;
+            {
+                RECHOR_TRACE_SCOPE("Import");
+                if(!importer->Import(fbxscene.get())) {
+                    logger::error("[FBX Importer] ", importer->GetStatus().GetErrorString());
+                    return false;
+                }
+                RECHOR_TRACE_ARG("nodes", fbxscene->GetNodeCount());
             }
 
             logger::debug("triangulate");
             FbxGeometryConverter geoconv(manager.get());
-            if(!geoconv.Triangulate(fbxscene.get(), true)) {
-                logger::warn("[WARN] triangulate failed.");
+            {
+                RECHOR_TRACE_SCOPE("Triangulate");
+                if(!geoconv.Triangulate(fbxscene.get(), true)) {
+                    logger::warn("[WARN] triangulate failed.");
+                }
             }
             logger::debug("split material");
-            if(!geoconv.SplitMeshesPerMaterial(fbxscene.get(), true)) {
-                logger::warn("[WARN] split material failed.");
+            {
+                RECHOR_TRACE_SCOPE("SplitMeshesPerMaterial");
+                if(!geoconv.SplitMeshesPerMaterial(fbxscene.get(), true)) {
+                    logger::warn("[WARN] split material failed.");
+                }
+                RECHOR_TRACE_ARG("meshes", fbxscene->GetMemberCount<FbxMesh>());
             }
 
             this->nodemap.clear();
@@ -489,10 +577,15 @@ namespace rechor {
             if(option & (OPTION::LOAD_MESH | OPTION::LOAD_BONEWEIGHT)) {
 
                 const auto mc = fbxscene->GetMemberCount<FbxMesh>();
+                const auto base = scene.meshes.size();
+                scene.meshes.resize(base + mc);
+                std::vector<FbxMesh*> meshes(mc);
+
+                /* node, material and base pose: serial */
                 for(int i = 0; i < mc; i++) {
-                    const auto mesh = fbxscene->GetMember<FbxMesh>(i);
+                    const auto mesh = meshes[i] = fbxscene->GetMember<FbxMesh>(i);
 
-                    MeshRaw rmesh;
+                    auto& rmesh = scene.meshes[base + i];
                     const auto node = mesh->GetNode();
                     rmesh.nodeName = node->GetName();
                     rmesh.invMeshBasePoseMatrix = node->EvaluateGlobalTransform().Inverse();
@@ -504,14 +597,26 @@ namespace rechor {
                         const auto mat = node->GetMaterial(mc == matc ? i : 0);
                         parseMaterial(mat, rmesh);
                     }
+                    if(option & OPTION::LOAD_BONEWEIGHT) {
+                        parseBonePose(mesh, rmesh);
+                    }
+                }
+
+                /* geometry: each mesh only reads its FbxMesh and writes its own slot */
+                util::parallel_for(static_cast<std::size_t>(mc), threads_, [&](std::size_t i) {
+                    auto& rmesh = scene.meshes[base + i];
                     if(option & OPTION::LOAD_POLYGON) {
-                        parseMesh(mesh, rmesh);
+                        RECHOR_TRACE_SCOPE("parseMesh");
+                        RECHOR_TRACE_ARG("mesh", i);
+                        parseMesh(meshes[i], rmesh);
+                        RECHOR_TRACE_ARG("polygon vertices", rmesh.indices.size());
                     }
                     if(option & OPTION::LOAD_BONEWEIGHT) {
-                        parseBoneWeight(mesh, rmesh);
+                        RECHOR_TRACE_SCOPE("parseBoneWeight");
+                        RECHOR_TRACE_ARG("mesh", i);
+                        parseBoneWeight(meshes[i], rmesh);
                     }
-                    scene.meshes.push_back(std::move(rmesh));
-                }
+                });
 
             }
             if(option & OPTION::LOAD_ANIM) {
@@ -525,6 +630,9 @@ namespace rechor {
                 ranim.start = static_cast<int>((offset.Get() + start.Get()) / FbxTime::GetOneFrameValue(FbxTime::eFrames60));
                 ranim.end = static_cast<int>((offset.Get() + stop.Get()) / FbxTime::GetOneFrameValue(FbxTime::eFrames60));
 
+                RECHOR_TRACE_SCOPE("parseAnim");
+                RECHOR_TRACE_ARG("meshes", scene.meshes.size());
+                RECHOR_TRACE_ARG("frames", ranim.end - ranim.start);
                 parseAnim(fbxscene.get(), scene, ranim);
 
                 scene.animes.push_back(std::move(ranim));
@@ -534,16 +642,31 @@ namespace rechor {
         }
 
     public:
-        explicit FBXImporter() {}
+        explicit FBXImporter() : threads_(1), reduce_(false), lods_(false), meshlets_(false) {}
         virtual ~FBXImporter() {}
 
+        // workers for mesh extraction, processing and anim baking (0: hardware threads, 1: serial)
+        void setThreads(uint threads) { threads_ = threads; }
+
+        // drop keys that interpolation reproduces within tolerance (off by default)
+        void setKeyReduction(const KeyReduction& reduction) { reduce_ = true; reduction_ = reduction; }
+        void disableKeyReduction() { reduce_ = false; }
+
+        // LOD chain per mesh after welding/optimization (off by default, see simplifier.hpp)
+        void setLodGeneration(const LodSettings& settings) { lods_ = true; lodSettings_ = settings; }
+        void disableLodGeneration() { lods_ = false; }
+
+        // meshlets of the full index buffer, built after LODs reorder the vertices (off by default, see meshlet.hpp)
+        void setMeshletGeneration(const MeshletSettings& settings = MeshletSettings()) { meshlets_ = true; meshletSettings_ = settings; }
+        void disableMeshletGeneration() { meshlets_ = false; }
+
         bool load(const char* const filename, FBX_IMPORTER_OPTION option = OPTION::LOAD_ALL) {
             return loadRaw(filename, rscene_, option);
         }
 
         bool load(const char* const filename, Scene& scene, FBX_IMPORTER_OPTION option = OPTION::LOAD_ALL) {
             if(!loadRaw(filename, rscene_, option)) { return false; }
-            processScene(scene, rscene_);
+            processScene(scene, rscene_, option);
             return true;
         }
 
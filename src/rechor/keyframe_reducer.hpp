@@ -0,0 +1,179 @@
+// rechor project
+// keyframe_reducer.hpp
+
+#ifndef _RHACT_RECHOR_KEYFRAME_REDUCER_HPP_
+#define _RHACT_RECHOR_KEYFRAME_REDUCER_HPP_
+
+#include <vector>
+#include <algorithm>
+
+#include "rechor.hpp"
+#include "anim_math.hpp"
+#include "../parallel.hpp"
+
+namespace rhakt {
+namespace rechor {
+
+    /* error allowed per track when dropping keys */
+    struct KeyReduction {
+        float position;     // model units
+        float rotation;     // radians
+        float scale;        // absolute scale factor
+
+        KeyReduction(float p = 0.001f, float r = 0.0005f, float s = 0.0005f) : position(p), rotation(r), scale(s) {}
+    };
+
+    namespace keyframe {
+
+        static const std::size_t KEY_SIZE = 10;
+
+        inline void loadKey(const float* k, TRS& trs) {
+            std::copy(k, k + 3, trs.t);
+            std::copy(k + 3, k + 7, trs.r);
+            std::copy(k + 7, k + 10, trs.s);
+        }
+
+        inline void storeKey(const TRS& trs, std::vector<float>& keys) {
+            keys.insert(keys.end(), trs.t, trs.t + 3);
+            keys.insert(keys.end(), trs.r, trs.r + 4);
+            keys.insert(keys.end(), trs.s, trs.s + 3);
+        }
+
+        inline bool within(const TRS& a, const TRS& b, const KeyReduction& opt) {
+            for(int i = 0; i < 3; i++) {
+                if(std::fabs(a.t[i] - b.t[i]) > opt.position) { return false; }
+                if(std::fabs(a.s[i] - b.s[i]) > opt.scale) { return false; }
+            }
+            return animmath::angle(a.r, b.r) <= opt.rotation;
+        }
+
+        /*
+         * greedy reduction of one track: a key is extended as far as
+         * interpolating to it keeps every skipped frame within tolerance.
+         * the reach is found by doubling the segment, then bisecting back,
+         * so a segment of L frames costs O(L log L) checks, not O(L^2).
+         * matrix(f) returns the 16 floats of frame f.
+         */
+        template <typename F>
+        KeyTrack reduceTrack(std::size_t frameCount, F&& matrix, const KeyReduction& opt) {
+            std::vector<TRS> poses(frameCount);
+            for(std::size_t f = 0; f < frameCount; f++) {
+                animmath::decompose(matrix(f), poses[f]);
+                // keep neighbours in one hemisphere so interpolation takes the short way
+                if(f > 0 && animmath::dot4(poses[f].r, poses[f - 1].r) < 0.f) {
+                    for(auto&& v : poses[f].r) { v = -v; }
+                }
+            }
+
+            KeyTrack track;
+            if(frameCount == 0) { return track; }
+            // every frame between key and end within tolerance of the interpolation
+            auto fits = [&](std::size_t key, std::size_t end) {
+                for(auto f = key + 1; f < end; f++) {
+                    TRS p;
+                    animmath::interpolate(poses[key], poses[end], static_cast<float>(f - key) / (end - key), p);
+                    if(!within(p, poses[f], opt)) { return false; }
+                }
+                return true;
+            };
+            std::size_t key = 0;
+            track.frames.push_back(0);
+            storeKey(poses[0], track.keys);
+            while(key + 1 < frameCount) {
+                auto good = key + 1, bad = frameCount;
+                for(std::size_t length = 2; ; length *= 2) {
+                    const auto end = std::min(key + length, frameCount - 1);
+                    if(end <= good) { break; }
+                    if(!fits(key, end)) {
+                        bad = end;
+                        break;
+                    }
+                    good = end;
+                }
+                while(bad - good > 1) {
+                    const auto mid = good + (bad - good) / 2;
+                    if(fits(key, mid)) { good = mid; } else { bad = mid; }
+                }
+                key = good;
+                track.frames.push_back(static_cast<uint>(key));
+                storeKey(poses[key], track.keys);
+            }
+            return track;
+        }
+
+        /* pose of a reduced track at (fractional) frame, as a 4x4 matrix */
+        inline void decodeTrack(const uint* frames, const float* keys, std::size_t count, float frame, float* out) {
+            if(count == 0) { return; }
+            TRS a, b, p;
+            const auto it = std::upper_bound(frames, frames + count, frame, [](float f, uint k) { return f < static_cast<float>(k); });
+            if(it == frames) {
+                loadKey(keys, p);
+            } else if(it == frames + count) {
+                loadKey(keys + (count - 1) * KEY_SIZE, p);
+            } else {
+                const auto i = static_cast<std::size_t>(it - frames) - 1;
+                loadKey(keys + i * KEY_SIZE, a);
+                loadKey(keys + (i + 1) * KEY_SIZE, b);
+                animmath::interpolate(a, b, (frame - frames[i]) / (frames[i + 1] - frames[i]), p);
+            }
+            animmath::compose(p, out);
+        }
+
+        inline void decodeTrack(const KeyTrack& track, float frame, float* out) {
+            decodeTrack(track.frames.data(), track.keys.data(), track.frames.size(), frame, out);
+        }
+
+    } // namespace keyframe
+
+    /* replace the baked matrices of every track by reduced keys (one worker per mesh) */
+    inline void reduceKeyframes(Anim& anim, const KeyReduction& opt, uint threads = 1) {
+        util::parallel_for(anim.meshes.size(), threads, [&](std::size_t i) {
+            auto& af = anim.meshes[i];
+            if(af.reduced()) { return; }
+            const auto fc = std::max(af.meshMatrices.frameCount, af.boneMatrices.frameCount);
+            if(fc == 0) { return; }
+
+            if(!af.meshMatrices.empty()) {
+                af.meshKeys = keyframe::reduceTrack(fc, [&](std::size_t f) { return af.meshMatrices.frame(f); }, opt);
+            }
+            if(!af.boneMatrices.empty()) {
+                const auto bc = af.boneMatrices.stride / 16;
+                af.boneKeys.resize(bc);
+                for(std::size_t b = 0; b < bc; b++) {
+                    af.boneKeys[b] = keyframe::reduceTrack(fc, [&](std::size_t f) { return af.boneMatrices.frame(f) + b * 16; }, opt);
+                }
+            }
+            af.frameCount = static_cast<uint>(fc);
+            af.meshMatrices.clear();
+            af.boneMatrices.clear();
+        });
+    }
+
+    /*
+     * rebuild one frame of a track set.
+     * meshMatrix receives 16 floats, boneMatrices 16 floats per bone (either may be null).
+     */
+    inline void decodeFrame(const AnimFrame& af, float frame, float* meshMatrix, float* boneMatrices) {
+        if(!af.reduced()) {
+            const auto f = static_cast<std::size_t>(frame);
+            if(meshMatrix && f < af.meshMatrices.frameCount) {
+                std::copy(af.meshMatrices.frame(f), af.meshMatrices.frame(f) + af.meshMatrices.stride, meshMatrix);
+            }
+            if(boneMatrices && f < af.boneMatrices.frameCount) {
+                std::copy(af.boneMatrices.frame(f), af.boneMatrices.frame(f) + af.boneMatrices.stride, boneMatrices);
+            }
+            return;
+        }
+        if(meshMatrix && !af.meshKeys.frames.empty()) {
+            keyframe::decodeTrack(af.meshKeys, frame, meshMatrix);
+        }
+        if(boneMatrices) {
+            for(std::size_t b = 0; b < af.boneKeys.size(); b++) {
+                keyframe::decodeTrack(af.boneKeys[b], frame, boneMatrices + b * 16);
+            }
+        }
+    }
+
+}} // namespace rhakt::rechor
+
+#endif
@@ -0,0 +1,277 @@
+// rechor project
+// mesh_optimizer.hpp
+
+#ifndef _RHACT_RECHOR_MESH_OPTIMIZER_HPP_
+#define _RHACT_RECHOR_MESH_OPTIMIZER_HPP_
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+
+#include "rechor.hpp"
+
+namespace rhakt {
+namespace rechor {
+namespace meshopt {
+
+    /* post-transform cache statistics of an index buffer */
+    struct CacheStats {
+        float acmr;     // transformed vertices per triangle (0.5 is ideal for big grids, 3 is worst)
+        float atvr;     // transformed vertices per referenced vertex (1 is ideal)
+    };
+
+    // FIFO of cacheSize entries, like most fixed function post-transform caches
+    inline CacheStats analyzeCache(const std::vector<int>& indices, std::size_t vertexCount, uint cacheSize = 16) {
+        std::vector<std::size_t> stamp(vertexCount, 0);
+        std::vector<bool> used(vertexCount, false);
+        std::size_t time = cacheSize + 1, misses = 0, unique = 0;
+        for(auto&& i : indices) {
+            if(time - stamp[i] > cacheSize) {
+                stamp[i] = time++;
+                misses++;
+            }
+            if(!used[i]) {
+                used[i] = true;
+                unique++;
+            }
+        }
+        const auto tc = indices.size() / 3;
+        return { tc ? static_cast<float>(misses) / tc : 0.f, unique ? static_cast<float>(misses) / unique : 0.f };
+    }
+
+    namespace detail {
+
+        static const int CACHE_SIZE = 32;
+
+        // Forsyth, "Linear-Speed Vertex Cache Optimisation"
+        inline float vertexScore(int cachePos, int remaining) {
+            if(remaining == 0) { return -1.f; }
+            auto score = 0.f;
+            if(cachePos >= 0) {
+                if(cachePos < 3) {
+                    // the last triangle's vertices: avoid reusing them right away
+                    score = 0.75f;
+                } else {
+                    score = std::pow(1.f - static_cast<float>(cachePos - 3) / (CACHE_SIZE - 3), 1.5f);
+                }
+            }
+            // favour vertices with few triangles left, so they do not linger
+            return score + 2.f / std::sqrt(static_cast<float>(remaining));
+        }
+
+        // triangles of each vertex, CSR style
+        struct Adjacency {
+            std::vector<uint> offsets;
+            std::vector<uint> triangles;
+
+            Adjacency(const std::vector<int>& indices, std::size_t vertexCount) : offsets(vertexCount + 1, 0), triangles(indices.size()) {
+                for(auto&& i : indices) { offsets[i + 1]++; }
+                std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+                std::vector<uint> fill(offsets.begin(), offsets.end() - 1);
+                for(std::size_t i = 0; i < indices.size(); i++) {
+                    triangles[fill[indices[i]]++] = static_cast<uint>(i / 3);
+                }
+            }
+        };
+
+        // move vertex v of every vertex stream of mesh to remap[v] (remap is a permutation)
+        inline void permuteStreams(Mesh& mesh, const std::vector<int>& remap) {
+            const auto vertexCount = remap.size();
+            auto permute = [&](auto& stream) {
+                if(stream.empty()) { return; }
+                const auto n = stream.size() / vertexCount;
+                std::remove_reference_t<decltype(stream)> dst(stream.size());
+                for(std::size_t v = 0; v < vertexCount; v++) {
+                    std::copy(stream.begin() + v * n, stream.begin() + (v + 1) * n, dst.begin() + remap[v] * n);
+                }
+                stream.swap(dst);
+            };
+            permute(mesh.vertices);
+            permute(mesh.normals);
+            permute(mesh.colors);
+            permute(mesh.uvs);
+            permute(mesh.boneIndices);
+            permute(mesh.boneWeights);
+        }
+
+    } // namespace detail
+
+    /* reorder triangles for post-transform cache locality */
+    inline void optimizeVertexCache(std::vector<int>& indices, std::size_t vertexCount) {
+        using namespace detail;
+        const auto tc = indices.size() / 3;
+        if(tc == 0) { return; }
+
+        Adjacency adj(indices, vertexCount);
+        std::vector<int> remaining(vertexCount), cachePos(vertexCount, -1);
+        std::vector<float> vscore(vertexCount), tscore(tc);
+        std::vector<bool> emitted(tc, false);
+        for(std::size_t v = 0; v < vertexCount; v++) {
+            remaining[v] = static_cast<int>(adj.offsets[v + 1] - adj.offsets[v]);
+            vscore[v] = vertexScore(-1, remaining[v]);
+        }
+        for(std::size_t t = 0; t < tc; t++) {
+            tscore[t] = vscore[indices[t * 3]] + vscore[indices[t * 3 + 1]] + vscore[indices[t * 3 + 2]];
+        }
+
+        std::vector<int> result;
+        result.reserve(indices.size());
+        std::vector<int> cache, next;
+        cache.reserve(CACHE_SIZE + 3);
+        next.reserve(CACHE_SIZE + 3);
+        std::size_t cursor = 0;
+        auto best = static_cast<std::size_t>(std::max_element(tscore.begin(), tscore.end()) - tscore.begin());
+
+        for(std::size_t n = 0; n < tc; n++) {
+            if(best >= tc) {
+                // nothing adjacent to the cache: take the next triangle in input order
+                while(emitted[cursor]) { cursor++; }
+                best = cursor;
+            }
+            const auto tri = &indices[best * 3];
+            emitted[best] = true;
+            result.insert(result.end(), tri, tri + 3);
+
+            /* the new triangle goes to the front of the LRU cache */
+            next.assign(tri, tri + 3);
+            for(auto&& v : cache) {
+                if(v != tri[0] && v != tri[1] && v != tri[2]) { next.push_back(v); }
+            }
+            for(int k = 0; k < 3; k++) {
+                auto& list = adj.triangles;
+                const auto v = tri[k];
+                remaining[v]--;
+                // keep the not yet emitted triangles at the front of the vertex's list
+                const auto begin = list.begin() + adj.offsets[v];
+                const auto it = std::find(begin, begin + remaining[v] + 1, static_cast<uint>(best));
+                std::iter_swap(it, begin + remaining[v]);
+            }
+            for(std::size_t i = CACHE_SIZE; i < next.size(); i++) { cachePos[next[i]] = -1; vscore[next[i]] = vertexScore(-1, remaining[next[i]]); }
+            if(next.size() > static_cast<std::size_t>(CACHE_SIZE)) { next.resize(CACHE_SIZE); }
+            cache.swap(next);
+
+            /* rescore cached vertices and their triangles, pick the best one */
+            for(std::size_t i = 0; i < cache.size(); i++) {
+                cachePos[cache[i]] = static_cast<int>(i);
+                vscore[cache[i]] = vertexScore(static_cast<int>(i), remaining[cache[i]]);
+            }
+            best = tc;
+            auto bestScore = -1.f;
+            for(auto&& v : cache) {
+                for(auto i = adj.offsets[v]; i < adj.offsets[v] + remaining[v]; i++) {
+                    const auto t = adj.triangles[i];
+                    tscore[t] = vscore[indices[t * 3]] + vscore[indices[t * 3 + 1]] + vscore[indices[t * 3 + 2]];
+                    if(tscore[t] > bestScore) {
+                        bestScore = tscore[t];
+                        best = t;
+                    }
+                }
+            }
+        }
+        indices.swap(result);
+    }
+
+    /*
+     * reorder clusters of triangles so outward facing ones come first,
+     * trading at most `threshold` times the current ACMR for less overdraw.
+     * vertices: 3 floats per vertex.
+     */
+    inline void optimizeOverdraw(std::vector<int>& indices, const std::vector<float>& vertices, float threshold = 1.05f, uint cacheSize = 16) {
+        const auto tc = indices.size() / 3;
+        const auto vertexCount = vertices.size() / 3;
+        if(tc == 0) { return; }
+        const auto target = analyzeCache(indices, vertexCount, cacheSize).acmr * threshold;
+
+        /* cut clusters where the cache would restart, or once a cluster is cheap enough */
+        std::vector<std::size_t> clusters;
+        std::vector<std::size_t> stamp(vertexCount, 0);
+        std::size_t time = cacheSize + 1, start = 0, misses = 0;
+        for(std::size_t t = 0; t < tc; t++) {
+            int m = 0;
+            for(int k = 0; k < 3; k++) {
+                const auto v = indices[t * 3 + k];
+                if(time - stamp[v] > cacheSize) {
+                    stamp[v] = time++;
+                    m++;
+                }
+            }
+            if(m == 3 && t > start) {
+                clusters.push_back(start);
+                start = t;
+                misses = 0;
+            }
+            misses += m;
+            if(static_cast<float>(misses) <= target * (t - start + 1) && t + 1 < tc) {
+                clusters.push_back(start);
+                start = t + 1;
+                misses = 0;
+                time += cacheSize + 1; // the next cluster starts cold
+            }
+        }
+        clusters.push_back(start);
+        clusters.push_back(tc);
+
+        float centroid[3] = { 0.f, 0.f, 0.f };
+        for(std::size_t v = 0; v < vertexCount; v++) {
+            for(int k = 0; k < 3; k++) { centroid[k] += vertices[v * 3 + k] / vertexCount; }
+        }
+
+        /* sort key: how much the cluster faces away from the mesh center */
+        const auto cc = clusters.size() - 1;
+        std::vector<float> key(cc);
+        for(std::size_t c = 0; c < cc; c++) {
+            float center[3] = { 0.f, 0.f, 0.f }, normal[3] = { 0.f, 0.f, 0.f }, area = 0.f;
+            for(auto t = clusters[c]; t < clusters[c + 1]; t++) {
+                const auto a = &vertices[indices[t * 3] * 3];
+                const auto b = &vertices[indices[t * 3 + 1] * 3];
+                const auto d = &vertices[indices[t * 3 + 2] * 3];
+                const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+                const float e2[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+                const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+                const auto w = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for(int k = 0; k < 3; k++) {
+                    center[k] += (a[k] + b[k] + d[k]) / 3.f * w;
+                    normal[k] += n[k];
+                }
+                area += w;
+            }
+            const auto nl = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            key[c] = 0.f;
+            if(area > 0.f && nl > 0.f) {
+                for(int k = 0; k < 3; k++) { key[c] += (center[k] / area - centroid[k]) * normal[k] / nl; }
+            }
+        }
+
+        std::vector<std::size_t> order(cc);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return key[a] > key[b]; });
+
+        std::vector<int> result;
+        result.reserve(indices.size());
+        for(auto&& c : order) {
+            result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+        }
+        indices.swap(result);
+    }
+
+    /* renumber vertices in order of first use and reorder every vertex stream to match */
+    inline void optimizeVertexFetch(Mesh& mesh) {
+        const auto vertexCount = mesh.vertices.size() / 3;
+        std::vector<int> remap(vertexCount, -1);
+        int next = 0;
+        for(auto&& i : mesh.indices) {
+            if(remap[i] < 0) { remap[i] = next++; }
+            i = remap[i];
+        }
+        // unreferenced vertices keep their relative order at the end
+        for(auto&& r : remap) {
+            if(r < 0) { r = next++; }
+        }
+        detail::permuteStreams(mesh, remap);
+    }
+
+}}} // namespace rhakt::rechor::meshopt
+
+#endif
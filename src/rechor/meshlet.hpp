@@ -0,0 +1,244 @@
+// rechor project
+// meshlet.hpp
+//
+// clusters of the index buffer for mesh shaders and GPU-driven culling.
+// a meshlet has at most 64 vertices and 124 triangles, a bounding sphere
+// and a normal cone; triangles are grown greedily over shared vertices.
+
+#ifndef _RHACT_RECHOR_MESHLET_HPP_
+#define _RHACT_RECHOR_MESHLET_HPP_
+
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include "rechor.hpp"
+#include "mesh_optimizer.hpp"
+
+namespace rhakt {
+namespace rechor {
+
+    /* limits of a meshlet and how much the builder favours flat ones */
+    struct MeshletSettings {
+        uint maxVertices;       // at most 256 (local indices are bytes)
+        uint maxTriangles;
+        float coneWeight;       // 0: compact spheres only, 1: tight normal cones only
+
+        MeshletSettings(uint v = 64, uint t = 124, float w = 0.25f) : maxVertices(v), maxTriangles(t), coneWeight(w) {}
+    };
+
+    namespace meshlet {
+
+        namespace detail {
+
+            inline float length3(const float* a) { return std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]); }
+
+            inline float distance3(const float* a, const float* b) {
+                const float d[] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+                return length3(d);
+            }
+
+            // unit normal and area of triangle t, zero normal when degenerate
+            inline float triangleNormal(const Mesh& mesh, std::size_t t, float* n) {
+                const auto p0 = &mesh.vertices[mesh.indices[t * 3] * 3];
+                const auto p1 = &mesh.vertices[mesh.indices[t * 3 + 1] * 3];
+                const auto p2 = &mesh.vertices[mesh.indices[t * 3 + 2] * 3];
+                const float e1[] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+                const float e2[] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+                n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+                n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+                n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+                const auto l = length3(n);
+                for(int k = 0; k < 3; k++) { n[k] = l > 0.f ? n[k] / l : 0.f; }
+                return l * 0.5f;
+            }
+
+            /*
+             * sphere around the vertices (centered on their box) and the cone
+             * of the triangle normals (meshoptimizer's formulation): the apex
+             * lies behind every triangle plane, so the whole cluster faces
+             * away from any camera with dot(normalize(apex - camera), axis) >= cutoff.
+             */
+            inline void computeBounds(const Mesh& mesh, const std::vector<uint>& vertices, const std::vector<uchar>& triangles, const float* normals, Meshlet& m) {
+                Aabb box;
+                for(auto v = m.vertexOffset; v < m.vertexOffset + m.vertexCount; v++) { box.extend(&mesh.vertices[vertices[v] * 3]); }
+                float r = 0.f;
+                for(int k = 0; k < 3; k++) { m.sphere.center[k] = (box.min[k] + box.max[k]) * 0.5f; }
+                for(auto v = m.vertexOffset; v < m.vertexOffset + m.vertexCount; v++) {
+                    r = std::max(r, distance3(&mesh.vertices[vertices[v] * 3], m.sphere.center));
+                }
+                m.sphere.radius = r;
+
+                // no cone unless every normal is within ~84 degrees of the mean
+                std::fill(m.coneAxis, m.coneAxis + 3, 0.f);
+                std::copy(m.sphere.center, m.sphere.center + 3, m.coneApex);
+                m.coneCutoff = 1.f;
+                float axis[3] = { 0.f, 0.f, 0.f };
+                for(uint t = 0; t < m.triangleCount; t++) {
+                    for(int k = 0; k < 3; k++) { axis[k] += normals[t * 3 + k]; }
+                }
+                const auto l = length3(axis);
+                if(!(l > 0.f)) { return; }
+                for(int k = 0; k < 3; k++) { axis[k] /= l; }
+                float minDot = 1.f;
+                for(uint t = 0; t < m.triangleCount; t++) {
+                    const auto n = normals + t * 3;
+                    if(n[0] == 0.f && n[1] == 0.f && n[2] == 0.f) { continue; }
+                    minDot = std::min(minDot, n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+                }
+                if(minDot <= 0.1f) { return; }
+
+                // move the apex back along the axis until it is behind every plane
+                float back = 0.f;
+                for(uint t = 0; t < m.triangleCount; t++) {
+                    const auto n = normals + t * 3;
+                    if(n[0] == 0.f && n[1] == 0.f && n[2] == 0.f) { continue; }
+                    const auto p = &mesh.vertices[vertices[m.vertexOffset + triangles[m.triangleOffset + t * 3]] * 3];
+                    const auto dc = (m.sphere.center[0] - p[0]) * n[0] + (m.sphere.center[1] - p[1]) * n[1] + (m.sphere.center[2] - p[2]) * n[2];
+                    const auto dn = axis[0] * n[0] + axis[1] * n[1] + axis[2] * n[2];
+                    back = std::max(back, dc / dn);
+                }
+                for(int k = 0; k < 3; k++) {
+                    m.coneAxis[k] = axis[k];
+                    m.coneApex[k] = m.sphere.center[k] - axis[k] * back;
+                }
+                m.coneCutoff = std::sqrt(1.f - minDot * minDot);
+            }
+
+        } // namespace detail
+
+        /* true when every triangle of m faces away from a camera at position (bind pose, rigid meshes) */
+        inline bool backfacing(const Meshlet& m, const float* camera) {
+            const float d[] = { m.coneApex[0] - camera[0], m.coneApex[1] - camera[1], m.coneApex[2] - camera[2] };
+            const auto l = detail::length3(d);
+            if(!(l > 0.f)) { return false; }
+            return (d[0] * m.coneAxis[0] + d[1] * m.coneAxis[1] + d[2] * m.coneAxis[2]) >= m.coneCutoff * l;
+        }
+
+    } // namespace meshlet
+
+    /*
+     * replaces mesh.meshlets/meshletVertices/meshletTriangles by clusters
+     * covering mesh.indices in order of construction. each one starts at the
+     * first triangle left and grows by the neighbouring triangle that adds
+     * the fewest vertices (finishing vertices first), ties going to the
+     * triangle closest to the cluster and its mean normal. disconnected parts
+     * join only when they are near. needs float streams (not interleaved).
+     */
+    inline void buildMeshlets(Mesh& mesh, const MeshletSettings& settings = MeshletSettings()) {
+        mesh.meshlets.clear();
+        mesh.meshletVertices.clear();
+        mesh.meshletTriangles.clear();
+        const auto vc = mesh.vertices.size() / 3;
+        const auto tc = mesh.indices.size() / 3;
+        if(vc == 0 || tc == 0 || mesh.indices.size() % 3 != 0) { return; }
+        const auto maxVertices = std::max(3U, std::min(settings.maxVertices, 256U));
+        const auto maxTriangles = std::max(1U, settings.maxTriangles);
+        const auto coneWeight = std::max(0.f, std::min(settings.coneWeight, 1.f));
+
+        const meshopt::detail::Adjacency adjacency(mesh.indices, vc);
+        std::vector<uint> live(vc);
+        for(std::size_t v = 0; v < vc; v++) { live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v]; }
+        std::vector<float> centroids(tc * 3), normals(tc * 3);
+        double area = 0.0;
+        for(std::size_t t = 0; t < tc; t++) {
+            area += meshlet::detail::triangleNormal(mesh, t, &normals[t * 3]);
+            for(int k = 0; k < 3; k++) {
+                centroids[t * 3 + k] = (mesh.vertices[mesh.indices[t * 3] * 3 + k] + mesh.vertices[mesh.indices[t * 3 + 1] * 3 + k]
+                    + mesh.vertices[mesh.indices[t * 3 + 2] * 3 + k]) / 3.f;
+            }
+        }
+        // radius of a full, flat meshlet of average triangles
+        const auto expected = static_cast<float>(std::sqrt(area / tc * maxTriangles / 3.14159265358979));
+        const auto scale = expected > 0.f ? 1.f / expected : 0.f;
+
+        mesh.meshletVertices.reserve(tc);
+        mesh.meshletTriangles.reserve(tc * 3);
+        std::vector<int> local(vc, -1);
+        std::vector<bool> emitted(tc, false);
+        std::vector<float> clusterNormals;
+        clusterNormals.reserve(maxTriangles * 3);
+        Meshlet current;
+        float center[3] = { 0.f, 0.f, 0.f }, axis[3] = { 0.f, 0.f, 0.f };
+
+        auto flush = [&]() {
+            if(current.triangleCount == 0) { return; }
+            for(auto v = current.vertexOffset; v < current.vertexOffset + current.vertexCount; v++) { local[mesh.meshletVertices[v]] = -1; }
+            meshlet::detail::computeBounds(mesh, mesh.meshletVertices, mesh.meshletTriangles, clusterNormals.data(), current);
+            mesh.meshlets.push_back(current);
+            current = Meshlet();
+            current.vertexOffset = static_cast<uint>(mesh.meshletVertices.size());
+            current.triangleOffset = static_cast<uint>(mesh.meshletTriangles.size());
+            std::fill(center, center + 3, 0.f);
+            std::fill(axis, axis + 3, 0.f);
+            clusterNormals.clear();
+        };
+        auto extra = [&](std::size_t t) {
+            int n = 0;
+            for(int c = 0; c < 3; c++) { n += local[mesh.indices[t * 3 + c]] < 0 ? 1 : 0; }
+            return n;
+        };
+        auto fits = [&](std::size_t t) {
+            return current.vertexCount + extra(t) <= maxVertices && current.triangleCount < maxTriangles;
+        };
+        auto add = [&](std::size_t t) {
+            for(int c = 0; c < 3; c++) {
+                const auto v = mesh.indices[t * 3 + c];
+                if(local[v] < 0) {
+                    local[v] = static_cast<int>(current.vertexCount++);
+                    mesh.meshletVertices.push_back(static_cast<uint>(v));
+                }
+                mesh.meshletTriangles.push_back(static_cast<uchar>(local[v]));
+                live[v]--;
+            }
+            emitted[t] = true;
+            const auto n = static_cast<float>(++current.triangleCount);
+            for(int k = 0; k < 3; k++) {
+                center[k] += (centroids[t * 3 + k] - center[k]) / n;
+                axis[k] += normals[t * 3 + k];
+                clusterNormals.push_back(normals[t * 3 + k]);
+            }
+        };
+
+        std::size_t next = 0;
+        for(std::size_t done = 0; done < tc; done++) {
+            long best = -1;
+            int bestExtra = 4;
+            float bestScore = FLT_MAX;
+            const auto al = meshlet::detail::length3(axis);
+            for(auto i = current.vertexOffset; i < current.vertexOffset + current.vertexCount; i++) {
+                const auto v = mesh.meshletVertices[i];
+                if(live[v] == 0) { continue; }
+                for(auto a = adjacency.offsets[v]; a < adjacency.offsets[v + 1]; a++) {
+                    const auto t = adjacency.triangles[a];
+                    if(emitted[t]) { continue; }
+                    auto e = extra(t);
+                    for(int c = 0; c < 3; c++) {
+                        if(live[mesh.indices[t * 3 + c]] == 1) { e = 0; }
+                    }
+                    const auto spread = al > 0.f ? (normals[t * 3] * axis[0] + normals[t * 3 + 1] * axis[1] + normals[t * 3 + 2] * axis[2]) / al : 1.f;
+                    const auto score = (1.f + meshlet::detail::distance3(&centroids[t * 3], center) * scale * (1.f - coneWeight))
+                        * (1.f - spread * coneWeight);
+                    if(e < bestExtra || (e == bestExtra && score < bestScore)) {
+                        best = t;
+                        bestExtra = e;
+                        bestScore = score;
+                    }
+                }
+            }
+            if(best < 0) {
+                // nothing connected left: the next triangle in index order, in this meshlet only when near
+                while(emitted[next]) { next++; }
+                best = static_cast<long>(next);
+                if(current.triangleCount > 0 && meshlet::detail::distance3(&centroids[best * 3], center) > 2.f * expected) { flush(); }
+            }
+            if(!fits(best)) { flush(); }
+            add(best);
+        }
+        flush();
+    }
+
+}} // namespace rhakt::rechor
+
+#endif
@@ -0,0 +1,177 @@
+// rechor project
+// quantize.hpp
+
+#ifndef _RHACT_RECHOR_QUANTIZE_HPP_
+#define _RHACT_RECHOR_QUANTIZE_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace rhakt {
+namespace rechor {
+namespace quantize {
+
+    /*-- value in [min, min + extent] <-> 16 bits --*/
+
+    inline std::uint16_t encodeRange(float v, float min, float extent) {
+        if(extent <= 0.f) { return 0; }
+        const auto n = std::min(std::max((v - min) / extent, 0.f), 1.f);
+        return static_cast<std::uint16_t>(n * 65535.f + 0.5f);
+    }
+
+    inline float decodeRange(std::uint16_t v, float min, float extent) {
+        return min + extent * (v / 65535.f);
+    }
+
+    /*
+     * smallest-three unit quaternion (x, y, z, w) in 48 bits:
+     * 2 bits for the dropped (largest) component, 15 bits for each of the others.
+     * the dropped one is made positive and rebuilt from the unit length.
+     */
+    static const float QUAT_RANGE = 0.70710678f; // others are within +-1/sqrt(2)
+
+    inline void encodeQuat(const float* q, std::uint16_t* out) {
+        int largest = 0;
+        for(int i = 1; i < 4; i++) {
+            if(std::fabs(q[i]) > std::fabs(q[largest])) { largest = i; }
+        }
+        const auto sign = q[largest] < 0.f ? -1.f : 1.f;
+        std::uint64_t bits = static_cast<std::uint64_t>(largest);
+        for(int i = 0; i < 4; i++) {
+            if(i == largest) { continue; }
+            const auto n = std::min(std::max((q[i] * sign / QUAT_RANGE) * 0.5f + 0.5f, 0.f), 1.f);
+            bits = (bits << 15) | static_cast<std::uint64_t>(n * 32767.f + 0.5f);
+        }
+        out[0] = static_cast<std::uint16_t>(bits);
+        out[1] = static_cast<std::uint16_t>(bits >> 16);
+        out[2] = static_cast<std::uint16_t>(bits >> 32);
+    }
+
+    inline void decodeQuat(const std::uint16_t* in, float* q) {
+        const auto bits = static_cast<std::uint64_t>(in[0]) | (static_cast<std::uint64_t>(in[1]) << 16) | (static_cast<std::uint64_t>(in[2]) << 32);
+        const auto largest = static_cast<int>((bits >> 45) & 0x3);
+        auto shift = 30;
+        auto sum = 0.f;
+        for(int i = 0; i < 4; i++) {
+            if(i == largest) { continue; }
+            const auto v = static_cast<float>((bits >> shift) & 0x7fff);
+            q[i] = (v / 32767.f * 2.f - 1.f) * QUAT_RANGE;
+            sum += q[i] * q[i];
+            shift -= 15;
+        }
+        q[largest] = std::sqrt(std::max(1.f - sum, 0.f));
+    }
+
+    /*-- [0, 1] <-> 8 bits --*/
+
+    inline std::uint8_t encodeUnorm8(float v) {
+        return static_cast<std::uint8_t>(std::min(std::max(v, 0.f), 1.f) * 255.f + 0.5f);
+    }
+
+    inline float decodeUnorm8(std::uint8_t v) {
+        return v / 255.f;
+    }
+
+    /*-- IEEE 754 half (round to nearest even) --*/
+
+    inline std::uint16_t encodeHalf(float v) {
+        std::uint32_t f;
+        std::memcpy(&f, &v, sizeof(f));
+        const auto sign = static_cast<std::uint16_t>((f >> 16) & 0x8000);
+        const auto exp = static_cast<int>((f >> 23) & 0xff);
+        auto mant = f & 0x7fffff;
+        if(exp == 0xff) {
+            // inf / nan
+            return static_cast<std::uint16_t>(sign | 0x7c00 | (mant ? 0x200 : 0));
+        }
+        auto e = exp - 127 + 15;
+        if(e >= 0x1f) {
+            return static_cast<std::uint16_t>(sign | 0x7c00);
+        }
+        if(e <= 0) {
+            // subnormal half (or zero)
+            if(e < -10) { return sign; }
+            mant |= 0x800000;
+            const auto shift = static_cast<std::uint32_t>(14 - e);
+            auto h = mant >> shift;
+            const auto rest = mant & ((1U << shift) - 1);
+            const auto half = 1U << (shift - 1);
+            if(rest > half || (rest == half && (h & 1))) { h++; }
+            return static_cast<std::uint16_t>(sign | h);
+        }
+        auto h = static_cast<std::uint32_t>(e << 10) | (mant >> 13);
+        const auto rest = mant & 0x1fff;
+        if(rest > 0x1000 || (rest == 0x1000 && (h & 1))) { h++; } // may carry into the exponent, which is correct
+        return static_cast<std::uint16_t>(sign | h);
+    }
+
+    inline float decodeHalf(std::uint16_t h) {
+        const auto sign = static_cast<std::uint32_t>(h & 0x8000) << 16;
+        const auto exp = (h >> 10) & 0x1f;
+        const auto mant = static_cast<std::uint32_t>(h & 0x3ff);
+        std::uint32_t f;
+        if(exp == 0) {
+            if(mant == 0) {
+                f = sign;
+            } else {
+                // normalize the subnormal
+                int e = -1;
+                auto m = mant;
+                do { e++; m <<= 1; } while((m & 0x400) == 0);
+                f = sign | (static_cast<std::uint32_t>(127 - 15 - e) << 23) | ((m & 0x3ff) << 13);
+            }
+        } else if(exp == 0x1f) {
+            f = sign | 0x7f800000 | (mant << 13);
+        } else {
+            f = sign | (static_cast<std::uint32_t>(exp - 15 + 127) << 23) | (mant << 13);
+        }
+        float v;
+        std::memcpy(&v, &f, sizeof(v));
+        return v;
+    }
+
+    /*-- unit vector <-> octahedral map, 2 x snorm16 --*/
+
+    inline std::int16_t encodeSnorm16(float v) {
+        const auto c = std::min(std::max(v, -1.f), 1.f) * 32767.f;
+        return static_cast<std::int16_t>(c < 0.f ? c - 0.5f : c + 0.5f);
+    }
+
+    inline float decodeSnorm16(std::int16_t v) {
+        return std::max(v / 32767.f, -1.f);
+    }
+
+    inline void encodeOct(const float* n, std::int16_t* out) {
+        const auto l1 = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+        auto x = l1 > 0.f ? n[0] / l1 : 0.f;
+        auto y = l1 > 0.f ? n[1] / l1 : 0.f;
+        if(n[2] < 0.f) {
+            // fold the lower hemisphere over the diagonals
+            const auto ox = x;
+            x = (1.f - std::fabs(y)) * (ox >= 0.f ? 1.f : -1.f);
+            y = (1.f - std::fabs(ox)) * (y >= 0.f ? 1.f : -1.f);
+        }
+        out[0] = encodeSnorm16(x);
+        out[1] = encodeSnorm16(y);
+    }
+
+    inline void decodeOct(const std::int16_t* in, float* n) {
+        auto x = decodeSnorm16(in[0]);
+        auto y = decodeSnorm16(in[1]);
+        const auto z = 1.f - std::fabs(x) - std::fabs(y);
+        if(z < 0.f) {
+            const auto ox = x;
+            x = (1.f - std::fabs(y)) * (ox >= 0.f ? 1.f : -1.f);
+            y = (1.f - std::fabs(ox)) * (y >= 0.f ? 1.f : -1.f);
+        }
+        const auto l = std::sqrt(x * x + y * y + z * z);
+        n[0] = x / l;
+        n[1] = y / l;
+        n[2] = z / l;
+    }
+
+}}} // namespace rhakt::rechor::quantize
+
+#endif
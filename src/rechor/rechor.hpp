@@ -6,11 +6,15 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <cfloat>
+#include <algorithm>
 
 #include <lz4.h>
 
 #include "../logger.hpp"
 #include "../util.hpp"
+#include "../arena.hpp"
 #include "scene_generated.h"
 
 namespace rhakt {
@@ -19,31 +23,268 @@ namespace rechor {
     typedef unsigned int uint;
     typedef unsigned char uchar;
 
-    struct AnimFrame {
-        std::vector<std::vector<float>> meshMatrices;
-        std::vector<std::vector<float>> boneMatrices;
+    // payload encoding of .rkr files
+    enum struct CODEC : uchar {
+        NONE = 0,   // plain flatbuffer (can be mapped directly)
+        LZ4 = 1
     };
 
-    struct Anim {
-        std::vector<AnimFrame> meshes;
+    // attributes of an interleaved vertex blob
+    enum struct VERTEX_SEMANTIC : uchar {
+        POSITION = 0,
+        NORMAL = 1,
+        COLOR = 2,
+        TEXCOORD = 3,
+        BONE_INDICES = 4,
+        BONE_WEIGHTS = 5
     };
 
-    struct Mesh {
-        std::vector<float> vertices;
-        std::vector<float> normals;
-        std::vector<int> indices;
-        std::vector<float> colors;
-        std::vector<float> uvs;
-        std::string texture;
-        std::vector<int> boneIndices;
-        std::vector<float> boneWeights;
+    enum struct VERTEX_FORMAT : uchar {
+        FLOAT1 = 0,
+        FLOAT2 = 1,
+        FLOAT3 = 2,
+        FLOAT4 = 3,
+        UINT8x4 = 4,
+        UINT16x4 = 5
     };
 
-    struct Scene {
-        std::vector<Mesh> meshes;
-        std::vector<Anim> animes;
+    struct VertexAttribute {
+        VERTEX_SEMANTIC semantic;
+        VERTEX_FORMAT format;
+        unsigned short offset;      // bytes from the start of a vertex
     };
 
+    // axis aligned box, empty until a point is added
+    struct Aabb {
+        float min[3];
+        float max[3];
+
+        Aabb() : min{ FLT_MAX, FLT_MAX, FLT_MAX }, max{ -FLT_MAX, -FLT_MAX, -FLT_MAX } {}
+
+        bool empty() const { return min[0] > max[0]; }
+
+        void extend(const float* p) {
+            for(int k = 0; k < 3; k++) {
+                min[k] = std::min(min[k], p[k]);
+                max[k] = std::max(max[k], p[k]);
+            }
+        }
+
+        void extend(const Aabb& b) {
+            if(b.empty()) { return; }
+            extend(b.min);
+            extend(b.max);
+        }
+    };
+
+    // empty while the radius is negative
+    struct Sphere {
+        float center[3];
+        float radius;
+
+        Sphere() : center{ 0.f, 0.f, 0.f }, radius(-1.f) {}
+
+        bool empty() const { return radius < 0.f; }
+    };
+
+    // cluster of a mesh for mesh shaders and culling (see meshlet.hpp)
+    struct Meshlet {
+        uint vertexOffset;          // first entry in meshletVertices
+        uint triangleOffset;        // first byte in meshletTriangles, 3 per triangle
+        uint vertexCount;
+        uint triangleCount;
+        Sphere sphere;
+        float coneApex[3];
+        float coneAxis[3];          // zero when the triangles face too many ways to cull
+        float coneCutoff;           // sine of the cone half angle, 1 without a cone
+
+        Meshlet() : vertexOffset(0), triangleOffset(0), vertexCount(0), triangleCount(0),
+                    coneApex{ 0.f, 0.f, 0.f }, coneAxis{ 0.f, 0.f, 0.f }, coneCutoff(1.f) {}
+    };
+
+    /*
+     * where the scene structs below allocate. HeapStorage is the default
+     * (Mesh, Scene, ...); ArenaStorage puts a whole scene in one util::Arena
+     * (ArenaMesh, ArenaScene, ...) so it is freed in one step.
+     */
+    struct HeapStorage {
+        typedef std::allocator<char> allocator_type;
+        template <typename T> using vector = std::vector<T>;
+        typedef std::string string;
+    };
+
+    struct ArenaStorage {
+        typedef util::ArenaAllocator<char> allocator_type;
+        template <typename T> using vector = std::vector<T, util::ArenaAllocator<T>>;
+        typedef std::basic_string<char, std::char_traits<char>, util::ArenaAllocator<char>> string;
+    };
+
+    template <typename S>
+    struct BasicVertexLayout {
+        typedef typename S::allocator_type allocator_type;
+
+        uint stride;                // bytes per vertex
+        typename S::template vector<VertexAttribute> attributes;
+
+        BasicVertexLayout() : stride(0) {}
+        explicit BasicVertexLayout(const allocator_type& a) : stride(0), attributes(a) {}
+    };
+
+    // keys kept by keyframe reduction, linearly interpolated in between
+    template <typename S>
+    struct BasicKeyTrack {
+        typedef typename S::allocator_type allocator_type;
+
+        typename S::template vector<uint> frames;   // ascending, first and last frame always kept
+        typename S::template vector<float> keys;    // translation(3) rotation(4) scale(3) per frame
+
+        BasicKeyTrack() {}
+        explicit BasicKeyTrack(const allocator_type& a) : frames(a), keys(a) {}
+    };
+
+    // frameCount frames of stride floats, back to back
+    template <typename S>
+    struct BasicTrack {
+        typedef typename S::allocator_type allocator_type;
+
+        uint frameCount;
+        uint stride;
+        typename S::template vector<float> data;
+
+        BasicTrack() : frameCount(0), stride(0) {}
+        explicit BasicTrack(const allocator_type& a) : frameCount(0), stride(0), data(a) {}
+
+        bool empty() const { return frameCount == 0; }
+        float* frame(std::size_t f) { return data.data() + f * stride; }
+        const float* frame(std::size_t f) const { return data.data() + f * stride; }
+
+        void resize(uint frames, uint floats) {
+            frameCount = frames;
+            stride = floats;
+            data.resize(static_cast<std::size_t>(frames) * floats);
+        }
+
+        void clear() {
+            frameCount = 0;
+            stride = 0;
+            data.clear();
+            data.shrink_to_fit();
+        }
+    };
+
+    template <typename S>
+    struct BasicAnimFrame {
+        typedef typename S::allocator_type allocator_type;
+
+        BasicTrack<S> meshMatrices;     // 4x4 matrix per frame
+        BasicTrack<S> boneMatrices;     // 4x4 matrix * bones per frame
+        /*-- reduced (matrices above are empty) --*/
+        uint frameCount;
+        BasicKeyTrack<S> meshKeys;
+        typename S::template vector<BasicKeyTrack<S>> boneKeys;
+        /*-- bounds of the animated mesh (see bounds.hpp), empty if the file has none --*/
+        Aabb bounds;                                    // whole clip
+        typename S::template vector<Aabb> frameBounds;  // one per frame
+
+        BasicAnimFrame() : frameCount(0) {}
+        explicit BasicAnimFrame(const allocator_type& a) : meshMatrices(a), boneMatrices(a), frameCount(0), meshKeys(a), boneKeys(a), frameBounds(a) {}
+        BasicAnimFrame(BasicTrack<S> mm, BasicTrack<S> bm)
+            : meshMatrices(std::move(mm)), boneMatrices(std::move(bm)), frameCount(0) {}
+
+        bool reduced() const { return frameCount > 0; }
+    };
+
+    template <typename S>
+    struct BasicAnim {
+        typedef typename S::allocator_type allocator_type;
+
+        typename S::template vector<BasicAnimFrame<S>> meshes;
+
+        BasicAnim() {}
+        explicit BasicAnim(const allocator_type& a) : meshes(a) {}
+    };
+
+    // coarser triangle list over the vertices of its mesh (see simplifier.hpp)
+    template <typename S>
+    struct BasicLod {
+        typedef typename S::allocator_type allocator_type;
+
+        typename S::template vector<int> indices;
+        uint vertexCount;           // every index is below it
+        float error;                // object space deviation from the full mesh (positions only)
+
+        BasicLod() : vertexCount(0), error(0.f) {}
+        explicit BasicLod(const allocator_type& a) : indices(a), vertexCount(0), error(0.f) {}
+    };
+
+    template <typename S>
+    struct BasicMesh {
+        typedef typename S::allocator_type allocator_type;
+
+        typename S::template vector<float> vertices;
+        typename S::template vector<float> normals;
+        typename S::template vector<int> indices;
+        typename S::template vector<float> colors;
+        typename S::template vector<float> uvs;
+        typename S::string texture;
+        typename S::template vector<int> boneIndices;
+        typename S::template vector<float> boneWeights;
+        /*-- interleaved (the streams above are empty) --*/
+        BasicVertexLayout<S> layout;
+        typename S::template vector<uchar> vertexBlob;  // layout.stride bytes per vertex
+        /*-- bind pose bounds (see bounds.hpp), empty if the file has none --*/
+        Aabb bounds;
+        Sphere sphere;
+        /*-- levels of detail, finest first --*/
+        typename S::template vector<BasicLod<S>> lods;
+        /*-- clusters of indices, empty unless built --*/
+        typename S::template vector<Meshlet> meshlets;
+        typename S::template vector<uint> meshletVertices;     // mesh vertex per meshlet vertex
+        typename S::template vector<uchar> meshletTriangles;   // meshlet local vertices, 3 per triangle
+
+        BasicMesh() {}
+        explicit BasicMesh(const allocator_type& a)
+            : vertices(a), normals(a), indices(a), colors(a), uvs(a), texture(a),
+              boneIndices(a), boneWeights(a), layout(a), vertexBlob(a), lods(a),
+              meshlets(a), meshletVertices(a), meshletTriangles(a) {}
+    };
+
+    template <typename S>
+    struct BasicScene {
+        typedef typename S::allocator_type allocator_type;
+
+        typename S::template vector<BasicMesh<S>> meshes;
+        typename S::template vector<BasicAnim<S>> animes;
+
+        BasicScene() {}
+        explicit BasicScene(const allocator_type& a) : meshes(a), animes(a) {}
+
+        allocator_type get_allocator() const { return allocator_type(meshes.get_allocator()); }
+    };
+
+    typedef BasicVertexLayout<HeapStorage> VertexLayout;
+    typedef BasicKeyTrack<HeapStorage> KeyTrack;
+    typedef BasicTrack<HeapStorage> Track;
+    typedef BasicAnimFrame<HeapStorage> AnimFrame;
+    typedef BasicAnim<HeapStorage> Anim;
+    typedef BasicLod<HeapStorage> Lod;
+    typedef BasicMesh<HeapStorage> Mesh;
+    typedef BasicScene<HeapStorage> Scene;
+
+    /*
+     * e.g. for a streaming loader:
+     *   util::Arena arena;                 // declared before the scene, outlives it
+     *   ArenaScene scene(arena);
+     *   importer.load(filename, scene);
+     */
+    typedef BasicVertexLayout<ArenaStorage> ArenaVertexLayout;
+    typedef BasicKeyTrack<ArenaStorage> ArenaKeyTrack;
+    typedef BasicTrack<ArenaStorage> ArenaTrack;
+    typedef BasicAnimFrame<ArenaStorage> ArenaAnimFrame;
+    typedef BasicAnim<ArenaStorage> ArenaAnim;
+    typedef BasicLod<ArenaStorage> ArenaLod;
+    typedef BasicMesh<ArenaStorage> ArenaMesh;
+    typedef BasicScene<ArenaStorage> ArenaScene;
 
 }} // namespace rhakt::rechor
 
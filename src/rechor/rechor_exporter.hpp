@@ -6,100 +6,825 @@
 
 #include <vector>
 #include <string>
+#include <atomic>
+#include <memory>
 
 #include <lz4.h>
 
 #include "rechor.hpp"
+#include "container.hpp"
+#include "anim_math.hpp"
+#include "quantize.hpp"
+#include "stream_filter.hpp"
+#include "vertex_layout.hpp"
+#include "bounds.hpp"
+#include "../parallel.hpp"
+#include "../trace.hpp"
 
 namespace rhakt {
 namespace rechor {
 
     class Exporter : private util::Noncopyable {
     private:
-        flatbuffers::FlatBufferBuilder fbb;
-    
-    public:
-        explicit Exporter() {}
-        virtual ~Exporter() {}
+        /*-- kept across saves so steady state conversions do not allocate --*/
+        std::unique_ptr<flatbuffers::FlatBufferBuilder> fbb_;
+        std::size_t fbbCapacity_;
+        std::vector<char> output_;      // header + compressed payload
+        std::vector<std::unique_ptr<flatbuffers::FlatBufferBuilder>> blockBuilders_;
+        std::vector<std::size_t> blockCapacities_;
 
-        bool save(const char* filename, const Scene& scene, bool binary = true) {
+        // offset lists and quantization ranges, one per block (and one for a whole scene)
+        struct Scratch {
+            std::vector<float> range, scale;
+            std::vector<flatbuffers::Offset<model::AnimFrame>> frames;
+            std::vector<flatbuffers::Offset<model::KeyTrack>> boneKeys;
+            std::vector<flatbuffers::Offset<model::Lod>> lods;
+            std::vector<flatbuffers::Offset<model::Mesh>> meshes;
+            std::vector<flatbuffers::Offset<model::Anim>> animes;
+        };
+        Scratch scratch_;
+        std::vector<Scratch> blockScratch_;
 
-            logger::info("saving...");
+        CODEC codec_;
+        bool chunked_;
+        bool quantizeBones_;
+        bool packVertices_;
+        bool filter_;
+        bool interleave_;
+        bool bounds_;
+        uint threads_;
+
+        /*-- bounds written with the scene, refilled per save --*/
+        struct MeshBounds {
+            Aabb box;
+            Sphere sphere;
+        };
+        struct AnimBounds {
+            Aabb clip;
+            std::vector<Aabb> frames;
+        };
+        std::vector<MeshBounds> meshBounds_;
+        std::vector<std::vector<AnimBounds>> animBounds_;   // per anim, per mesh
+        std::vector<std::pair<std::size_t, std::size_t>> animJobs_;
+        std::vector<std::vector<float>> animPalettes_;   // per anim job: decoded bone palette
+
+        struct Block {
+            ChunkEntry entry;
+            std::vector<char> data;
+        };
+        std::vector<Block> blocks_;
+
+        // writes straight into the builder; buf is valid until the next builder call
+        template <typename T>
+        static flatbuffers::Offset<flatbuffers::Vector<T>> createUninitializedVector(flatbuffers::FlatBufferBuilder& fbb, std::size_t len, T** buf) {
+            std::uint8_t* p = nullptr;
+            const auto o = fbb.CreateUninitializedVector(len, sizeof(T), &p);
+            *buf = reinterpret_cast<T*>(p);
+            return flatbuffers::Offset<flatbuffers::Vector<T>>(o);
+        }
+
+        template <typename T>
+        static std::size_t bytes(const std::vector<T>& v) { return v.size() * sizeof(T) + 8; }
+
+        // upper bound of the unpacked flatbuffer size (packed/quantized data is smaller)
+        static std::size_t estimateSize(const Mesh& m) {
+            return bytes(m.vertices) + bytes(m.normals) + bytes(m.indices) + bytes(m.colors) + bytes(m.uvs)
+                + m.texture.size() + bytes(m.boneIndices) + bytes(m.boneWeights) + bytes(m.vertexBlob)
+                + m.layout.attributes.size() * 4 + 192 + lodSize(m)
+                + m.meshlets.size() * 15 * 4 + bytes(m.meshletVertices) + bytes(m.meshletTriangles) + 64;
+        }
 
-            std::vector<flatbuffers::Offset<model::Mesh>> mm(scene.meshes.size());
-            std::vector<flatbuffers::Offset<model::Anim>> aa;
+        static std::size_t lodSize(const Mesh& m) {
+            std::size_t size = 0;
+            for(auto&& l : m.lods) { size += bytes(l.indices) + 48; }
+            return size;
+        }
+
+        static std::size_t estimateSize(const Anim& a) {
+            std::size_t size = 64;
+            for(auto&& m : a.meshes) {
+                size += bytes(m.meshMatrices.data) + bytes(m.boneMatrices.data) + 64;
+                size += bytes(m.meshKeys.frames) + bytes(m.meshKeys.keys) + 32;
+                for(auto&& k : m.boneKeys) { size += bytes(k.frames) + bytes(k.keys) + 32; }
+                const std::size_t fc = m.reduced() ? m.frameCount : std::max(m.meshMatrices.frameCount, m.boneMatrices.frameCount);
+                size += (fc + 1) * sizeof(Aabb) + 16;
+                size += 96;
+            }
+            return size;
+        }
+
+        static std::size_t estimateSize(const Scene& scene) {
+            std::size_t size = 64;
+            for(auto&& m : scene.meshes) { size += estimateSize(m); }
+            for(auto&& a : scene.animes) { size += estimateSize(a); }
+            return size;
+        }
+
+        // cleared builder able to hold estimate bytes without growing
+        static flatbuffers::FlatBufferBuilder& reuse(std::unique_ptr<flatbuffers::FlatBufferBuilder>& b, std::size_t& capacity, std::size_t estimate) {
+            if(!b || estimate > capacity) {
+                // flatbuffers wants room for the vtables and alignment on top; the
+                // finished buffer ends at the reserved size, so keep that 16 byte aligned
+                capacity = (std::max(estimate + estimate / 8, capacity) + 15) & ~static_cast<std::size_t>(15);
+                b.reset(new flatbuffers::FlatBufferBuilder(static_cast<flatbuffers::uoffset_t>(capacity)));
+            } else {
+                b->Clear();
+            }
+            return *b;
+        }
+
+        static_assert(sizeof(Aabb) == 6 * sizeof(float), "Aabb is written as 6 floats");
+
+        // box min(3) max(3), sphere center(3) radius
+        static flatbuffers::Offset<flatbuffers::Vector<float>> createBounds(flatbuffers::FlatBufferBuilder& fbb, const MeshBounds& b) {
+            if(b.box.empty()) { return 0; }
+            float* v;
+            auto o = createUninitializedVector(fbb, 10, &v);
+            std::memcpy(v, &b.box, sizeof(Aabb));
+            std::copy(b.sphere.center, b.sphere.center + 3, v + 6);
+            v[9] = b.sphere.radius;
+            return o;
+        }
+
+        // levels of detail, with 16 bit indices like the packed mesh when narrow
+        static flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<model::Lod>>> createLods(flatbuffers::FlatBufferBuilder& fbb, const Mesh& m, bool narrow, Scratch& scratch) {
+            if(m.lods.empty()) { return 0; }
+            auto& lods = scratch.lods;
+            lods.resize(m.lods.size());
+            for(std::size_t i = 0; i < m.lods.size(); i++) {
+                const auto& l = m.lods[i];
+                flatbuffers::Offset<flatbuffers::Vector<int32_t>> index;
+                flatbuffers::Offset<flatbuffers::Vector<std::uint16_t>> index16;
+                if(narrow) {
+                    std::uint16_t* idx;
+                    index16 = createUninitializedVector(fbb, l.indices.size(), &idx);
+                    std::copy(l.indices.begin(), l.indices.end(), idx);
+                } else {
+                    index = fbb.CreateVector(l.indices);
+                }
+                model::LodBuilder lb(fbb);
+                if(narrow) { lb.add_indices16(index16); } else { lb.add_indices(index); }
+                lb.add_vertexCount(l.vertexCount);
+                lb.add_error(l.error);
+                lods[i] = lb.Finish();
+            }
+            return fbb.CreateVector(lods);
+        }
+
+        // ranges and bounds flattened per meshlet, see scene.fbs
+        static flatbuffers::Offset<model::Meshlets> createMeshlets(flatbuffers::FlatBufferBuilder& fbb, const Mesh& m) {
+            if(m.meshlets.empty()) { return 0; }
+            const auto n = m.meshlets.size();
+            std::uint32_t* r;
+            auto ranges = createUninitializedVector(fbb, n * 4, &r);
+            for(auto&& ml : m.meshlets) {
+                *r++ = ml.vertexOffset;
+                *r++ = ml.triangleOffset;
+                *r++ = ml.vertexCount;
+                *r++ = ml.triangleCount;
+            }
+            float* b;
+            auto bounds = createUninitializedVector(fbb, n * 11, &b);
+            for(auto&& ml : m.meshlets) {
+                b = std::copy(ml.sphere.center, ml.sphere.center + 3, b);
+                *b++ = ml.sphere.radius;
+                b = std::copy(ml.coneApex, ml.coneApex + 3, b);
+                b = std::copy(ml.coneAxis, ml.coneAxis + 3, b);
+                *b++ = ml.coneCutoff;
+            }
+            auto vertices = fbb.CreateVector(m.meshletVertices);
+            auto triangles = fbb.CreateVector(m.meshletTriangles);
+            model::MeshletsBuilder mb(fbb);
+            mb.add_ranges(ranges);
+            mb.add_vertices(vertices);
+            mb.add_triangles(triangles);
+            mb.add_bounds(bounds);
+            return mb.Finish();
+        }
+
+        static flatbuffers::Offset<model::PackedMesh> createPackedMesh(flatbuffers::FlatBufferBuilder& fbb, const Mesh& m) {
+            const auto vc = m.vertices.size() / 3;
+
+            /* positions normalized to the AABB */
+            float bmin[3] = { 0.f, 0.f, 0.f }, bext[3] = { 0.f, 0.f, 0.f };
+            for(int k = 0; k < 3 && vc > 0; k++) {
+                auto lo = m.vertices[k], hi = lo;
+                for(std::size_t v = 0; v < vc; v++) {
+                    lo = std::min(lo, m.vertices[v * 3 + k]);
+                    hi = std::max(hi, m.vertices[v * 3 + k]);
+                }
+                bmin[k] = lo;
+                bext[k] = hi - lo;
+            }
+            // 8 bit bone indices only if every index fits, otherwise Mesh.boneIndices stays
+            const auto narrow = std::all_of(m.boneIndices.begin(), m.boneIndices.end(), [](int i) { return i >= 0 && i < 256; });
+
+            /* every stream is encoded straight into the builder */
+            auto vmin = fbb.CreateVector(bmin, 3);
+            auto vext = fbb.CreateVector(bext, 3);
+
+            std::uint16_t* pos;
+            auto vpos = createUninitializedVector(fbb, vc * 3, &pos);
+            for(std::size_t i = 0; i < vc * 3; i++) {
+                pos[i] = quantize::encodeRange(m.vertices[i], bmin[i % 3], bext[i % 3]);
+            }
 
-            std::transform(scene.meshes.begin(), scene.meshes.end(), mm.begin(), [&](auto& m){
-                auto vertex = fbb.CreateVector(m.vertices);
-                auto normal = fbb.CreateVector(m.normals);
-                auto index = fbb.CreateVector(m.indices);
-                auto color = fbb.CreateVector(m.colors);
-                auto uv = fbb.CreateVector(m.uvs);
+            std::int16_t* nor;
+            auto vnor = createUninitializedVector(fbb, m.normals.size() / 3 * 2, &nor);
+            for(std::size_t v = 0; v < m.normals.size() / 3; v++) {
+                quantize::encodeOct(&m.normals[v * 3], &nor[v * 2]);
+            }
+
+            std::uint16_t* uv;
+            auto vuv = createUninitializedVector(fbb, m.uvs.size(), &uv);
+            std::transform(m.uvs.begin(), m.uvs.end(), uv, quantize::encodeHalf);
+
+            std::uint8_t* col;
+            auto vcol = createUninitializedVector(fbb, m.colors.size(), &col);
+            std::transform(m.colors.begin(), m.colors.end(), col, quantize::encodeUnorm8);
+
+            flatbuffers::Offset<flatbuffers::Vector<std::uint8_t>> vbi;
+            if(narrow) {
+                std::uint8_t* bi;
+                vbi = createUninitializedVector(fbb, m.boneIndices.size(), &bi);
+                std::copy(m.boneIndices.begin(), m.boneIndices.end(), bi);
+            }
+
+            // unorm8 weights, the rounding error goes to the largest one so they sum to 255
+            std::uint8_t* bw;
+            auto vbw = createUninitializedVector(fbb, m.boneWeights.size(), &bw);
+            std::fill(bw, bw + m.boneWeights.size(), 0);
+            for(std::size_t v = 0; v + 4 <= m.boneWeights.size(); v += 4) {
+                int sum = 0;
+                std::size_t largest = v;
+                for(auto k = v; k < v + 4; k++) {
+                    bw[k] = quantize::encodeUnorm8(m.boneWeights[k]);
+                    sum += bw[k];
+                    if(m.boneWeights[k] > m.boneWeights[largest]) { largest = k; }
+                }
+                if(sum > 0) {
+                    bw[largest] = static_cast<std::uint8_t>(std::min(std::max(bw[largest] + 255 - sum, 0), 255));
+                }
+            }
+
+            flatbuffers::Offset<flatbuffers::Vector<std::uint16_t>> vidx;
+            if(vc < 65536) {
+                std::uint16_t* idx;
+                vidx = createUninitializedVector(fbb, m.indices.size(), &idx);
+                std::copy(m.indices.begin(), m.indices.end(), idx);
+            }
+
+            model::PackedMeshBuilder pb(fbb);
+            pb.add_vertexCount(static_cast<std::uint32_t>(vc));
+            pb.add_boundsMin(vmin);
+            pb.add_boundsExtent(vext);
+            pb.add_positions(vpos);
+            pb.add_normals(vnor);
+            pb.add_uvs(vuv);
+            pb.add_colors(vcol);
+            if(narrow) { pb.add_boneIndices(vbi); }
+            pb.add_boneWeights(vbw);
+            if(vc < 65536) { pb.add_indices16(vidx); }
+            return pb.Finish();
+        }
+
+        static flatbuffers::Offset<model::Mesh> createInterleavedMesh(flatbuffers::FlatBufferBuilder& fbb, const Mesh& m, const MeshBounds& bounds, Scratch& scratch) {
+            const auto interleave = m.vertexBlob.empty();
+            VertexLayout tmpLayout;
+            if(interleave) { tmpLayout = makeVertexLayout(m); }
+            const auto& layout = interleave ? tmpLayout : m.layout;
+            const auto blobSize = interleave ? m.vertices.size() / 3 * layout.stride : m.vertexBlob.size();
+
+            model::VertexAttribute* attrs;
+            const auto va = createUninitializedVector(fbb, layout.attributes.size(), &attrs);
+            for(std::size_t i = 0; i < layout.attributes.size(); i++) {
+                const auto& a = layout.attributes[i];
+                attrs[i] = model::VertexAttribute(static_cast<std::uint8_t>(a.semantic), static_cast<std::uint8_t>(a.format), a.offset);
+            }
+            model::VertexLayoutBuilder lb(fbb);
+            lb.add_stride(layout.stride);
+            lb.add_attributes(flatbuffers::Offset<flatbuffers::Vector<const model::VertexAttribute*>>(va.o));
+            auto vl = lb.Finish();
+            // force_align: 16, so the blob can go straight into a vertex buffer. Align raises the
+            // builder's minimum alignment (PreAlign does not in every flatbuffers release), so the
+            // finished buffer starts on 16 bytes and the blob offset counts from there
+            fbb.Align(16);
+            fbb.PreAlign(blobSize, 16);
+            uchar* blob;
+            auto vb = createUninitializedVector(fbb, blobSize, &blob);
+            if(interleave) {
+                interleaveVertices(m, layout, blob);
+            } else {
+                std::copy(m.vertexBlob.begin(), m.vertexBlob.end(), blob);
+            }
+            auto index = fbb.CreateVector(m.indices);
+            auto tex = fbb.CreateString(m.texture);
+            auto bb = createBounds(fbb, bounds);
+            auto lods = createLods(fbb, m, false, scratch);
+            auto meshlets = createMeshlets(fbb, m);
+            model::MeshBuilder mb(fbb);
+            mb.add_indices(index);
+            mb.add_texture(tex);
+            mb.add_layout(vl);
+            mb.add_vertexBlob(vb);
+            if(!bb.IsNull()) { mb.add_bounds(bb); }
+            if(!lods.IsNull()) { mb.add_lods(lods); }
+            if(!meshlets.IsNull()) { mb.add_meshlets(meshlets); }
+            return mb.Finish();
+        }
+
+        static flatbuffers::Offset<model::Mesh> createMesh(flatbuffers::FlatBufferBuilder& fbb, const Mesh& m, const MeshBounds& bounds, bool pack, bool interleave, Scratch& scratch) {
+            if(interleave || !m.vertexBlob.empty()) {
+                return createInterleavedMesh(fbb, m, bounds, scratch);
+            }
+            if(pack) {
+                const auto packed = createPackedMesh(fbb, m);
+                const auto vc = m.vertices.size() / 3;
+                const auto wideBones = std::any_of(m.boneIndices.begin(), m.boneIndices.end(), [](int i) { return i < 0 || i >= 256; });
+                flatbuffers::Offset<flatbuffers::Vector<int32_t>> index, bi;
+                if(vc >= 65536) { index = fbb.CreateVector(m.indices); }
+                if(wideBones) { bi = fbb.CreateVector(m.boneIndices); }
                 auto tex = fbb.CreateString(m.texture);
-                auto bi = fbb.CreateVector(m.boneIndices);
-                auto bw = fbb.CreateVector(m.boneWeights);
+                auto bb = createBounds(fbb, bounds);
+                auto lods = createLods(fbb, m, vc < 65536, scratch);
+                auto meshlets = createMeshlets(fbb, m);
                 model::MeshBuilder mb(fbb);
-                mb.add_vertices(vertex);
-                mb.add_normals(normal);
-                mb.add_indices(index);
-                mb.add_colors(color);
-                mb.add_uvs(uv);
+                if(vc >= 65536) { mb.add_indices(index); }
                 mb.add_texture(tex);
-                mb.add_boneIndices(bi);
-                mb.add_boneWeights(bw);
-                return std::move(mb.Finish());
+                if(wideBones) { mb.add_boneIndices(bi); }
+                mb.add_packed(packed);
+                if(!bb.IsNull()) { mb.add_bounds(bb); }
+                if(!lods.IsNull()) { mb.add_lods(lods); }
+                if(!meshlets.IsNull()) { mb.add_meshlets(meshlets); }
+                return mb.Finish();
+            }
+            auto vertex = fbb.CreateVector(m.vertices);
+            auto normal = fbb.CreateVector(m.normals);
+            auto index = fbb.CreateVector(m.indices);
+            auto color = fbb.CreateVector(m.colors);
+            auto uv = fbb.CreateVector(m.uvs);
+            auto tex = fbb.CreateString(m.texture);
+            auto bi = fbb.CreateVector(m.boneIndices);
+            auto bw = fbb.CreateVector(m.boneWeights);
+            auto bb = createBounds(fbb, bounds);
+            auto lods = createLods(fbb, m, false, scratch);
+            auto meshlets = createMeshlets(fbb, m);
+            model::MeshBuilder mb(fbb);
+            mb.add_vertices(vertex);
+            mb.add_normals(normal);
+            mb.add_indices(index);
+            mb.add_colors(color);
+            mb.add_uvs(uv);
+            mb.add_texture(tex);
+            mb.add_boneIndices(bi);
+            mb.add_boneWeights(bw);
+            if(!bb.IsNull()) { mb.add_bounds(bb); }
+            if(!lods.IsNull()) { mb.add_lods(lods); }
+            if(!meshlets.IsNull()) { mb.add_meshlets(meshlets); }
+            return mb.Finish();
+        }
+
+        static flatbuffers::Offset<model::KeyTrack> createKeyTrack(flatbuffers::FlatBufferBuilder& fbb, const KeyTrack& k) {
+            auto frames = fbb.CreateVector(k.frames);
+            auto keys = fbb.CreateVector(k.keys);
+            model::KeyTrackBuilder kb(fbb);
+            kb.add_frames(frames);
+            kb.add_keys(keys);
+            return kb.Finish();
+        }
+
+        static flatbuffers::Offset<model::Track> createTrack(flatbuffers::FlatBufferBuilder& fbb, const Track& t) {
+            auto data = fbb.CreateVector(t.data.data(), static_cast<std::size_t>(t.frameCount) * t.stride);
+            model::TrackBuilder tb(fbb);
+            tb.add_frameCount(t.frameCount);
+            tb.add_stride(t.stride);
+            tb.add_data(data);
+            return tb.Finish();
+        }
+
+        // true when every bone of every frame scales its three axes alike (QuantizedBones keeps one scale per bone)
+        static bool uniformScale(const Track& frames) {
+            const std::size_t bc = frames.stride / 16;
+            for(std::size_t f = 0; f < frames.frameCount; f++) {
+                for(std::size_t b = 0; b < bc; b++) {
+                    const auto m = frames.frame(f) + b * 16;
+                    float s[3];
+                    for(int r = 0; r < 3; r++) { s[r] = std::sqrt(m[r * 4] * m[r * 4] + m[r * 4 + 1] * m[r * 4 + 1] + m[r * 4 + 2] * m[r * 4 + 2]); }
+                    const auto hi = std::max(s[0], std::max(s[1], s[2]));
+                    const auto lo = std::min(s[0], std::min(s[1], s[2]));
+                    if(hi - lo > 1e-3f * hi) { return false; }
+                }
+            }
+            return true;
+        }
+
+        // frames: 4x4 matrix * bones per frame
+        static flatbuffers::Offset<model::QuantizedBones> createQuantizedBones(flatbuffers::FlatBufferBuilder& fbb, const Track& frames, Scratch& scratch) {
+            const std::size_t fc = frames.frameCount;
+            const std::size_t bc = frames.stride / 16;
+            // ranges (min, extent) and scales
+            auto& range = scratch.range;
+            auto& scale = scratch.scale;
+
+            /* translation range per bone */
+            range.assign(bc * 6, 0.f);
+            const auto rmin = range.data(), rext = range.data() + bc * 3;
+            for(std::size_t b = 0; b < bc; b++) {
+                for(int k = 0; k < 3; k++) {
+                    auto lo = frames.frame(0)[b * 16 + 12 + k], hi = lo;
+                    for(std::size_t f = 1; f < fc; f++) {
+                        lo = std::min(lo, frames.frame(f)[b * 16 + 12 + k]);
+                        hi = std::max(hi, frames.frame(f)[b * 16 + 12 + k]);
+                    }
+                    rmin[b * 3 + k] = lo;
+                    rext[b * 3 + k] = hi - lo;
+                }
+            }
+
+            /* rotations (and scales) straight into the builder */
+            std::uint16_t* rot;
+            auto vrot = createUninitializedVector(fbb, fc * bc * 3, &rot);
+            scale.resize(fc * bc);
+            bool unit = true;
+            for(std::size_t f = 0; f < fc; f++) {
+                for(std::size_t b = 0; b < bc; b++) {
+                    const auto i = f * bc + b;
+                    float m[16];
+                    std::copy(frames.frame(f) + b * 16, frames.frame(f) + (b + 1) * 16, m);
+                    // mirrored basis: flip all three axes and keep the sign in the scale
+                    const auto det =
+                        m[0] * (m[5] * m[10] - m[6] * m[9]) -
+                        m[1] * (m[4] * m[10] - m[6] * m[8]) +
+                        m[2] * (m[4] * m[9] - m[5] * m[8]);
+                    if(det < 0.f) {
+                        for(int r = 0; r < 3; r++) { for(int k = 0; k < 3; k++) { m[r * 4 + k] = -m[r * 4 + k]; } }
+                    }
+                    TRS trs;
+                    animmath::decompose(m, trs);
+                    quantize::encodeQuat(trs.r, &rot[i * 3]);
+                    scale[i] = (trs.s[0] + trs.s[1] + trs.s[2]) / 3.f * (det < 0.f ? -1.f : 1.f);
+                    if(std::fabs(scale[i] - 1.f) > 1e-5f) { unit = false; }
+                }
+            }
+
+            // the translation is row 3 as is
+            std::uint16_t* trans;
+            auto vtrans = createUninitializedVector(fbb, fc * bc * 3, &trans);
+            for(std::size_t f = 0; f < fc; f++) {
+                for(std::size_t b = 0; b < bc; b++) {
+                    for(int k = 0; k < 3; k++) {
+                        trans[(f * bc + b) * 3 + k] = quantize::encodeRange(frames.frame(f)[b * 16 + 12 + k], rmin[b * 3 + k], rext[b * 3 + k]);
+                    }
+                }
+            }
+
+            flatbuffers::Offset<flatbuffers::Vector<float>> vscale;
+            if(!unit) { vscale = fbb.CreateVector(scale.data(), scale.size()); }
+            auto vmin = fbb.CreateVector(rmin, bc * 3);
+            auto vext = fbb.CreateVector(rext, bc * 3);
+            model::QuantizedBonesBuilder qb(fbb);
+            qb.add_frameCount(static_cast<std::uint32_t>(fc));
+            qb.add_boneCount(static_cast<std::uint32_t>(bc));
+            qb.add_rotations(vrot);
+            qb.add_translations(vtrans);
+            if(!unit) { qb.add_scales(vscale); }
+            qb.add_rangeMin(vmin);
+            qb.add_rangeExtent(vext);
+            return qb.Finish();
+        }
+
+        static flatbuffers::Offset<model::Anim> createAnim(flatbuffers::FlatBufferBuilder& fbb, const Anim& a, const std::vector<AnimBounds>& bounds, bool quantizeBones, Scratch& scratch) {
+            auto& af = scratch.frames;
+            auto& bk = scratch.boneKeys;
+            af.clear();
+            for(std::size_t i = 0; i < a.meshes.size(); i++) {
+                const auto& m = a.meshes[i];
+                flatbuffers::Offset<model::Track> mt, bt;
+                if(!m.meshMatrices.empty()) {
+                    mt = createTrack(fbb, m.meshMatrices);
+                }
+                flatbuffers::Offset<model::QuantizedBones> qb;
+                auto quantized = quantizeBones && !m.boneMatrices.empty() && m.boneMatrices.stride >= 16;
+                if(quantized && !uniformScale(m.boneMatrices)) {
+                    logger::warn("[RKR] non-uniform bone scale in anim mesh ", i, ", bones kept at full precision");
+                    quantized = false;
+                }
+                if(quantized) {
+                    qb = createQuantizedBones(fbb, m.boneMatrices, scratch);
+                } else if(!m.boneMatrices.empty()) {
+                    bt = createTrack(fbb, m.boneMatrices);
+                }
+                flatbuffers::Offset<model::KeyTrack> mk;
+                flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<model::KeyTrack>>> vbk;
+                if(m.reduced()) {
+                    mk = createKeyTrack(fbb, m.meshKeys);
+                    bk.clear();
+                    for(auto&& k : m.boneKeys) {
+                        bk.push_back(createKeyTrack(fbb, k));
+                    }
+                    vbk = fbb.CreateVector(bk);
+                }
+                const auto& b = bounds[i];
+                flatbuffers::Offset<flatbuffers::Vector<float>> cb, fb;
+                if(!b.clip.empty()) {
+                    cb = fbb.CreateVector(&b.clip.min[0], 6);
+                    float* v;
+                    fb = createUninitializedVector(fbb, b.frames.size() * 6, &v);
+                    if(!b.frames.empty()) { std::memcpy(v, b.frames.data(), b.frames.size() * sizeof(Aabb)); }
+                }
+                model::AnimFrameBuilder afb(fbb);
+                if(!m.meshMatrices.empty()) {
+                    afb.add_meshTrack(mt);
+                }
+                if(!m.boneMatrices.empty() && !quantized) {
+                    afb.add_boneTrack(bt);
+                }
+                if(m.reduced()) {
+                    afb.add_frameCount(m.frameCount);
+                    afb.add_meshKeys(mk);
+                    afb.add_boneKeys(vbk);
+                }
+                if(quantized) {
+                    afb.add_quantizedBones(qb);
+                }
+                if(!b.clip.empty()) {
+                    afb.add_bounds(cb);
+                    afb.add_frameBounds(fb);
+                }
+                af.push_back(afb.Finish());
+            }
+            auto ms = fbb.CreateVector(af);
+            model::AnimBuilder ab(fbb);
+            ab.add_meshes(ms);
+            return ab.Finish();
+        }
+
+        // bounds of every mesh and animated mesh: computed, or as stored in the scene
+        void prepareBounds(const Scene& scene) {
+            RECHOR_TRACE_SCOPE("bounds");
+            meshBounds_.resize(scene.meshes.size());
+            util::parallel_for(scene.meshes.size(), threads_, [&](std::size_t i) {
+                const auto& m = scene.meshes[i];
+                auto& b = meshBounds_[i];
+                if(bounds_) {
+                    b.box = bounds::computeAabb(m);
+                    b.sphere = bounds::computeSphere(m, b.box);
+                } else {
+                    b.box = m.bounds;
+                    b.sphere = m.sphere;
+                }
+            });
+
+            // one job per animated mesh (anim, mesh), the skinned ones dominate
+            auto& jobs = animJobs_;
+            jobs.clear();
+            animBounds_.resize(scene.animes.size());
+            for(std::size_t a = 0; a < scene.animes.size(); a++) {
+                animBounds_[a].resize(scene.animes[a].meshes.size());
+                for(std::size_t k = 0; k < scene.animes[a].meshes.size(); k++) { jobs.emplace_back(a, k); }
+            }
+            animPalettes_.resize(jobs.size());
+            util::parallel_for(jobs.size(), threads_, [&](std::size_t j) {
+                const auto& af = scene.animes[jobs[j].first].meshes[jobs[j].second];
+                auto& b = animBounds_[jobs[j].first][jobs[j].second];
+                if(!bounds_) {
+                    b.clip = af.bounds;
+                    b.frames.assign(af.frameBounds.begin(), af.frameBounds.end());
+                } else if(jobs[j].second < scene.meshes.size()) {
+                    bounds::computeAnimBounds(scene.meshes[jobs[j].second], meshBounds_[jobs[j].second].box, af, b.clip, b.frames, animPalettes_[j]);
+                } else {
+                    b.clip = Aabb();
+                    b.frames.clear();
+                }
             });
+        }
+
+        // compress (or copy) a finished flatbuffer into block
+        static bool encodeBlock(CODEC codec, flatbuffers::FlatBufferBuilder& builder, Block& block) {
+            RECHOR_TRACE_SCOPE(codec == CODEC::NONE ? "copy block" : "lz4");
+            const auto input = reinterpret_cast<const char *>(builder.GetBufferPointer());
+            const auto inputsize = builder.GetSize();
+            RECHOR_TRACE_ARG("bytes", inputsize);
+            if(codec == CODEC::NONE) {
+                block.data.assign(input, input + inputsize);
+            } else {
+                block.data.resize(LZ4_compressBound(inputsize));
+                const auto outputsize = LZ4_compress_default(input, block.data.data(), inputsize, static_cast<int>(block.data.size()));
+                if(outputsize <= 0) {
+                    logger::error("[LZ4] compress error");
+                    return false;
+                }
+                block.data.resize(outputsize);
+                RECHOR_TRACE_ARG("compressed", outputsize);
+            }
+            block.entry.codec = static_cast<std::uint8_t>(codec);
+            block.entry.reserved = 0;
+            block.entry.size = block.data.size();
+            block.entry.rawSize = inputsize;
+            block.entry.checksum = util::xxh64(block.data.data(), block.data.size());
+            return true;
+        }
+
+        bool saveChunked(const char* filename, const Scene& scene) {
+            const auto mc = scene.meshes.size();
+            const auto ac = scene.animes.size();
+            const auto bc = mc + ac;
+            blocks_.resize(bc);
+            if(blockBuilders_.size() < bc) {
+                blockBuilders_.resize(bc);
+                blockCapacities_.resize(bc, 0);
+                blockScratch_.resize(bc);
+            }
+            std::atomic<bool> ok(true);
+            const auto filtered = filter_ && codec_ == CODEC::LZ4;
 
-            for(auto&& a : scene.animes) {
-                std::vector<flatbuffers::Offset<model::AnimFrame>> af;
-                for(auto&& m : a.meshes) {
-                    std::vector<flatbuffers::Offset<model::Frame>> mmf;
-                    for(auto&& mf : m.meshMatrices) {
-                        auto data = fbb.CreateVector(mf);
-                        model::FrameBuilder fb(fbb);
-                        fb.add_data(data);
-                        mmf.push_back(std::move(fb.Finish()));
+            util::parallel_for(bc, threads_, [&](std::size_t i) {
+                auto& block = blocks_[i];
+                filter::StreamFilter sf(true);
+                if(i < mc) {
+                    auto& builder = reuse(blockBuilders_[i], blockCapacities_[i], estimateSize(scene.meshes[i]));
+                    {
+                        RECHOR_TRACE_SCOPE("build mesh");
+                        RECHOR_TRACE_ARG("vertices", scene.meshes[i].vertices.size() / 3);
+                        RECHOR_TRACE_ARG("indices", scene.meshes[i].indices.size());
+                        builder.Finish(createMesh(builder, scene.meshes[i], meshBounds_[i], packVertices_, interleave_, blockScratch_[i]));
+                        RECHOR_TRACE_ARG("bytes", builder.GetSize());
                     }
-                    std::vector<flatbuffers::Offset<model::Frame>> bif;
-                    for(auto&& bf : m.boneMatrices) {
-                        auto data = fbb.CreateVector(bf);
-                        model::FrameBuilder fb(fbb);
-                        fb.add_data(data);
-                        bif.push_back(std::move(fb.Finish()));
+                    block.entry.kind = static_cast<std::uint8_t>(CHUNK_KIND::MESH);
+                    block.entry.index = static_cast<std::uint32_t>(i);
+                    if(filtered) {
+                        RECHOR_TRACE_SCOPE("filter");
+                        sf.apply(flatbuffers::GetRoot<model::Mesh>(builder.GetBufferPointer()));
                     }
-                    auto vmmf = fbb.CreateVector(mmf);
-                    auto vbif = fbb.CreateVector(bif);
-                    model::AnimFrameBuilder afb(fbb);
-                    afb.add_meshMatrices(vmmf);
-                    afb.add_boneMatrices(vbif);
-                    af.push_back(std::move(afb.Finish()));
+                    if(!encodeBlock(codec_, builder, block)) { ok = false; }
+                } else {
+                    auto& builder = reuse(blockBuilders_[i], blockCapacities_[i], estimateSize(scene.animes[i - mc]));
+                    {
+                        RECHOR_TRACE_SCOPE("build anim");
+                        RECHOR_TRACE_ARG("meshes", scene.animes[i - mc].meshes.size());
+                        builder.Finish(createAnim(builder, scene.animes[i - mc], animBounds_[i - mc], quantizeBones_, blockScratch_[i]));
+                        RECHOR_TRACE_ARG("bytes", builder.GetSize());
+                    }
+                    block.entry.kind = static_cast<std::uint8_t>(CHUNK_KIND::ANIM);
+                    block.entry.index = static_cast<std::uint32_t>(i - mc);
+                    if(filtered) {
+                        RECHOR_TRACE_SCOPE("filter");
+                        sf.apply(flatbuffers::GetRoot<model::Anim>(builder.GetBufferPointer()));
+                    }
+                    if(!encodeBlock(codec_, builder, block)) { ok = false; }
                 }
-                auto ms = fbb.CreateVector(af);
-                model::AnimBuilder ab(fbb);
-                ab.add_meshes(ms);
-                aa.push_back(std::move(ab.Finish()));
+            });
+            if(!ok) { return false; }
+
+            /* directory, then blocks aligned for in place access */
+            const auto dirsize = container::directorySize(bc);
+            std::size_t offset = dirsize;
+            std::uint64_t rawSize = 0;
+            for(std::size_t i = 0; i < bc; i++) {
+                auto& b = blocks_[i];
+                offset = container::alignBlock(offset);
+                b.entry.offset = offset;
+                offset += b.data.size();
+                rawSize += b.entry.rawSize;
             }
-            auto mesh = fbb.CreateVector(mm);
-            auto anim = fbb.CreateVector(aa);
 
-            model::SceneBuilder sb(fbb);
-            sb.add_meshes(mesh);
-            sb.add_animes(anim);
+            // header space in front, so the file goes out in one write
+            output_.assign(sizeof(FileHeader) + offset, 0);
+            const auto payload = output_.data() + sizeof(FileHeader);
+            const std::uint32_t counts[2] = { static_cast<std::uint32_t>(mc), static_cast<std::uint32_t>(ac) };
+            std::memcpy(payload, counts, sizeof(counts));
+            for(std::size_t i = 0; i < bc; i++) {
+                std::memcpy(payload + sizeof(counts) + i * sizeof(ChunkEntry), &blocks_[i].entry, sizeof(ChunkEntry));
+                std::memcpy(payload + blocks_[i].entry.offset, blocks_[i].data.data(), blocks_[i].data.size());
+            }
 
-            model::FinishSceneBuffer(fbb, sb.Finish());
+            auto header = container::makeHeader(codec_, static_cast<std::size_t>(rawSize), payload, dirsize);
+            header.flags |= container::FLAG_CHUNKED;
+            if(filtered) { header.flags |= container::FLAG_FILTERED; }
+            header.payloadSize = offset;
+            std::memcpy(output_.data(), &header, sizeof(header));
+            RECHOR_TRACE_SCOPE("write file");
+            RECHOR_TRACE_ARG("bytes", output_.size());
+            return util::writefile(filename, output_.data(), output_.size());
+        }
 
-            const auto inputsize = fbb.GetSize();
-            std::unique_ptr<char> dest(new char[LZ4_compressBound(inputsize)]);
-            auto outputsize = LZ4_compress(reinterpret_cast<const char *>(fbb.GetBufferPointer()), dest.get(), inputsize);
-            if(outputsize <= 0) {
-                logger::error("[LZ4] compress error");
-                return false;
+    public:
+        explicit Exporter() : fbbCapacity_(0), codec_(CODEC::LZ4), chunked_(false), quantizeBones_(false), packVertices_(false), filter_(true), interleave_(false), bounds_(true), threads_(1) {}
+        virtual ~Exporter() {}
+
+        // CODEC::NONE stores the flatbuffer as is so SceneView maps it without copy
+        void setCodec(CODEC codec) { codec_ = codec; }
+
+        // independent block per mesh and per anim, loadable one by one
+        void setChunked(bool chunked) { chunked_ = chunked; }
+
+        // store bone matrices as quantized TRS (~12 bytes per bone instead of 64); tracks with non-uniform scale stay full precision
+        void setQuantizeBones(bool quantize) { quantizeBones_ = quantize; }
+
+        /*
+         * quantized vertex streams: 16 bit positions in the mesh AABB, octahedral
+         * normals, half UVs, RGBA8 colors, 8 bit bone indices/weights and
+         * 16 bit indices below 65536 vertices
+         */
+        void setPackVertices(bool pack) { packVertices_ = pack; }
+
+        // one interleaved, 16 byte aligned vertex blob per mesh (takes precedence over setPackVertices)
+        void setInterleave(bool interleave) { interleave_ = interleave; }
+
+        // lossless stream filters ahead of LZ4 (ignored for CODEC::NONE, which stays mappable)
+        void setFilter(bool filter) { filter_ = filter; }
+
+        /*
+         * compute the bind pose box/sphere of every mesh and the per frame boxes of
+         * every animated mesh (skinned with its bone palettes) while saving.
+         * off: Mesh::bounds/sphere and AnimFrame::bounds/frameBounds are written as they are.
+         */
+        void setBounds(bool compute) { bounds_ = compute; }
+
+        // workers used for chunked files and bounds (0: hardware threads)
+        void setThreads(uint threads) { threads_ = threads; }
+
+        [[deprecated("the format is always binary")]]
+        bool save(const char* filename, const Scene& scene, bool) { return save(filename, scene); }
+
+        bool save(const char* filename, const Scene& scene) {
+
+            logger::info("saving...");
+            RECHOR_TRACE_SCOPE("Exporter::save");
+            RECHOR_TRACE_ARG("meshes", scene.meshes.size());
+            RECHOR_TRACE_ARG("animes", scene.animes.size());
+
+            prepareBounds(scene);
+
+            if(chunked_) {
+                const auto ok = saveChunked(filename, scene);
+                if(!ok) {
+                    logger::error("[RKR] SaveFile error");
+                }
+                return ok;
+            }
+
+            auto& fbb = reuse(fbb_, fbbCapacity_, estimateSize(scene));
+            {
+                RECHOR_TRACE_SCOPE("build flatbuffer");
+                auto& mm = scratch_.meshes;
+                auto& aa = scratch_.animes;
+                mm.resize(scene.meshes.size());
+                aa.resize(scene.animes.size());
+
+                for(std::size_t i = 0; i < scene.meshes.size(); i++) {
+                    mm[i] = createMesh(fbb, scene.meshes[i], meshBounds_[i], packVertices_, interleave_, scratch_);
+                }
+                for(std::size_t i = 0; i < scene.animes.size(); i++) {
+                    aa[i] = createAnim(fbb, scene.animes[i], animBounds_[i], quantizeBones_, scratch_);
+                }
+                auto mesh = fbb.CreateVector(mm);
+                auto anim = fbb.CreateVector(aa);
+
+                model::SceneBuilder sb(fbb);
+                sb.add_meshes(mesh);
+                sb.add_animes(anim);
+
+                model::FinishSceneBuffer(fbb, sb.Finish());
+                RECHOR_TRACE_ARG("bytes", fbb.GetSize());
             }
 
-            auto ok = util::savefile(filename, binary, dest.get(), outputsize);
+            const auto inputsize = fbb.GetSize();
+            const auto input = reinterpret_cast<const char *>(fbb.GetBufferPointer());
+            bool ok;
+            if(codec_ == CODEC::NONE) {
+                const auto header = container::makeHeader(codec_, inputsize, input, inputsize);
+                RECHOR_TRACE_SCOPE("write file");
+                RECHOR_TRACE_ARG("bytes", sizeof(header) + inputsize);
+                ok = util::writefile(filename, reinterpret_cast<const char *>(&header), sizeof(header), input, inputsize);
+            } else {
+                if(filter_) {
+                    RECHOR_TRACE_SCOPE("filter");
+                    RECHOR_TRACE_ARG("bytes", inputsize);
+                    filter::StreamFilter(true).apply(model::GetScene(input));
+                }
+                // compressed right behind the header space, so the file goes out in one write
+                output_.resize(sizeof(FileHeader) + LZ4_compressBound(inputsize));
+                const auto dest = output_.data() + sizeof(FileHeader);
+                int outputsize;
+                {
+                    RECHOR_TRACE_SCOPE("lz4");
+                    RECHOR_TRACE_ARG("bytes", inputsize);
+                    outputsize = LZ4_compress_default(input, dest, inputsize, LZ4_compressBound(inputsize));
+                    RECHOR_TRACE_ARG("compressed", outputsize);
+                }
+                if(outputsize <= 0) {
+                    logger::error("[LZ4] compress error");
+                    return false;
+                }
+                auto header = container::makeHeader(codec_, inputsize, dest, outputsize);
+                if(filter_) { header.flags |= container::FLAG_FILTERED; }
+                std::memcpy(output_.data(), &header, sizeof(header));
+                RECHOR_TRACE_SCOPE("write file");
+                RECHOR_TRACE_ARG("bytes", sizeof(header) + outputsize);
+                ok = util::writefile(filename, output_.data(), sizeof(header) + outputsize);
+            }
 
-            fbb.ReleaseBufferPointer();
-            
             if(!ok) {
                 logger::error("[Flatbuffers] SaveFile error");
             }
@@ -6,119 +6,284 @@
 
 #include <vector>
 #include <string>
+#include <cstring>
 
 #include <lz4.h>
 
 #include "rechor.hpp"
+#include "scene_view.hpp"
+#include "anim_math.hpp"
+#include "quantize.hpp"
 
 namespace rhakt {
 namespace rechor {
 
     class Importer : private util::Noncopyable {
+    private:
+        uint threads_;
+
+        template <typename V, typename U>
+        static void assign(V& dst, const util::array_view<U>& src) {
+            dst.assign(src.begin(), src.end());
+        }
+
+        // arena vectors resize without zeroing (see util::ArenaAllocator), so copy in bulk
+        template <typename T>
+        static void assign(std::vector<T, util::ArenaAllocator<T>>& dst, const util::array_view<T>& src) {
+            dst.resize(src.size());
+            if(!src.empty()) { std::memcpy(dst.data(), src.data(), src.size() * sizeof(T)); }
+        }
+
+        // flat tracks in one copy, legacy files frame by frame
+        template <typename F, typename S>
+        static void copyTrack(const util::array_view<float>& flat, std::size_t frameCount, F&& frame, BasicTrack<S>& dst) {
+            if(frameCount == 0) { return; }
+            const auto stride = static_cast<uint>(frame(0).size());
+            if(!flat.empty()) {
+                assign(dst.data, flat);
+            } else {
+                dst.data.resize(frameCount * stride);
+                for(std::size_t f = 0; f < frameCount; f++) {
+                    // frames of another size than the first are cut or zero padded
+                    const auto v = frame(f);
+                    const auto n = std::min<std::size_t>(v.size(), stride);
+                    std::copy(v.begin(), v.begin() + n, dst.data.begin() + f * stride);
+                    std::fill(dst.data.begin() + f * stride + n, dst.data.begin() + (f + 1) * stride, 0.f);
+                }
+            }
+            dst.frameCount = static_cast<uint>(frameCount);
+            dst.stride = stride;
+        }
+
+        static void copyBounds(const util::array_view<float>& src, Aabb& dst) {
+            std::copy(src.begin(), src.begin() + 3, dst.min);
+            std::copy(src.begin() + 3, src.begin() + 6, dst.max);
+        }
+
     public:
-        explicit Importer() {}
-        virtual ~Importer() {}
+        /*
+         * rebuild the bone matrices of one frame from quantized TRS.
+         * out receives 16 floats per bone.
+         */
+        static void decodeBones(const model::QuantizedBones* q, std::size_t frame, float* out) {
+            const auto bc = q->boneCount();
+            const auto rot = q->rotations()->data() + frame * bc * 3;
+            const auto trans = q->translations()->data() + frame * bc * 3;
+            const auto scale = q->scales() ? q->scales()->data() + frame * bc : nullptr;
+            const auto rmin = q->rangeMin()->data();
+            const auto rext = q->rangeExtent()->data();
+            for(auto b = 0U; b < bc; b++) {
+                TRS trs;
+                quantize::decodeQuat(rot + b * 3, trs.r);
+                for(int k = 0; k < 3; k++) {
+                    trs.t[k] = quantize::decodeRange(trans[b * 3 + k], rmin[b * 3 + k], rext[b * 3 + k]);
+                    trs.s[k] = scale ? scale[b] : 1.f;
+                }
+                animmath::compose(trs, out + b * 16);
+            }
+        }
 
-        bool load(const char* filename, Scene& scene) {
-            
-            logger::info("loading...");
-            
-            std::string buf;
-            if(!util::loadfile(filename, true, buf)) {
-                logger::error("[Flatbuffers] LoadFile error");
-                return false;
+        // bone matrices of one frame, quantized or not (16 floats per bone)
+        static void decodeBones(const AnimFrameView& view, std::size_t frame, float* out) {
+            if(view.quantized()) {
+                decodeBones(view.quantizedBones(), frame, out);
+            } else {
+                const auto bm = view.boneMatrices(frame);
+                std::copy(bm.begin(), bm.end(), out);
             }
+        }
 
-            const auto inputsize = buf.size();
-            std::unique_ptr<char> dest(new char[inputsize * 10]);
-            auto outputsize = LZ4_decompress_safe(buf.data(), dest.get(), inputsize, inputsize * 10);
-            if (outputsize <= 0) {
-                logger::error("[LZ4] decompress error");
-                return false;
+        /* decode packed streams into the float streams of mesh (absent ones are left alone) */
+        template <typename S>
+        static void unpack(const model::PackedMesh* p, BasicMesh<S>& mesh) {
+            const std::size_t vc = p->vertexCount();
+            const auto bmin = p->boundsMin()->data();
+            const auto bext = p->boundsExtent()->data();
+            const auto pos = p->positions()->data();
+            mesh.vertices.resize(vc * 3);
+            for(std::size_t i = 0; i < vc * 3; i++) {
+                mesh.vertices[i] = quantize::decodeRange(pos[i], bmin[i % 3], bext[i % 3]);
+            }
+            if(p->normals() && p->normals()->size()) {
+                mesh.normals.resize(vc * 3);
+                for(std::size_t v = 0; v < vc; v++) {
+                    quantize::decodeOct(p->normals()->data() + v * 2, &mesh.normals[v * 3]);
+                }
+            }
+            if(p->uvs() && p->uvs()->size()) {
+                mesh.uvs.resize(p->uvs()->size());
+                std::transform(p->uvs()->data(), p->uvs()->data() + p->uvs()->size(), mesh.uvs.begin(), quantize::decodeHalf);
+            }
+            if(p->colors() && p->colors()->size()) {
+                mesh.colors.resize(p->colors()->size());
+                std::transform(p->colors()->data(), p->colors()->data() + p->colors()->size(), mesh.colors.begin(), quantize::decodeUnorm8);
             }
+            if(p->boneIndices() && p->boneIndices()->size()) {
+                mesh.boneIndices.assign(p->boneIndices()->data(), p->boneIndices()->data() + p->boneIndices()->size());
+            }
+            if(p->boneWeights() && p->boneWeights()->size()) {
+                mesh.boneWeights.resize(p->boneWeights()->size());
+                std::transform(p->boneWeights()->data(), p->boneWeights()->data() + p->boneWeights()->size(), mesh.boneWeights.begin(), quantize::decodeUnorm8);
+            }
+            if(p->indices16() && p->indices16()->size()) {
+                mesh.indices.assign(p->indices16()->data(), p->indices16()->data() + p->indices16()->size());
+            }
+        }
+
+        explicit Importer() : threads_(1) {}
+        virtual ~Importer() {}
+
+        // workers used to decode chunked files (0: hardware threads)
+        void setThreads(uint threads) { threads_ = threads; }
 
-            auto s = model::GetScene(reinterpret_cast<const void*>(dest.get()));
+        /*
+         * trusted: skip the flatbuffers verifier (the checksum is always checked).
+         * an ArenaScene takes every buffer from its arena instead of the heap.
+         */
+        template <typename S>
+        bool load(const char* filename, BasicScene<S>& scene, bool trusted = false) {
+            return load(filename, scene, Selection(), trusted);
+        }
+
+        // only the selected meshes/anims are loaded, in index order
+        template <typename S>
+        bool load(const char* filename, BasicScene<S>& scene, const Selection& sel, bool trusted = false) {
             
-            auto m = s->meshes();
-            scene.meshes.reserve(m->size());
-            for(auto&& mm : *m) {
-                Mesh mesh;
-                // TODO: 
-                mesh.vertices.reserve(mm->vertices()->size());
-                for(auto&& v : *(mm->vertices())) {
-                    mesh.vertices.push_back(v);
-                }
+            logger::info("loading...");
+            RECHOR_TRACE_SCOPE("Importer::load");
 
-                mesh.normals.reserve(mm->normals()->size());
-                for(auto&& v : *(mm->normals())) {
-                    mesh.normals.push_back(v);
-                }
+            SceneView view;
+            view.setThreads(threads_);
+            if(!view.open(filename, trusted, sel)) {
+                return false;
+            }
+            return load(view, scene);
+        }
 
-                mesh.indices.reserve(mm->indices()->size());
-                for(auto&& v : *(mm->indices())) {
-                    mesh.indices.push_back(v);
+        /* copy everything in view into scene (built in place, with the scene's allocator), false on inconsistent data */
+        template <typename S>
+        bool load(const SceneView& view, BasicScene<S>& scene) {
+            RECHOR_TRACE_SCOPE("copy scene");
+            RECHOR_TRACE_ARG("meshes", view.meshCount());
+            RECHOR_TRACE_ARG("animes", view.animCount());
+            const auto alloc = scene.get_allocator();
+            const auto mc = view.meshCount();
+            scene.meshes.reserve(scene.meshes.size() + mc);
+            for(auto i = 0U; i < mc; i++) {
+                if(!view.hasMesh(i)) { continue; }
+                const auto mm = view.mesh(i);
+                scene.meshes.emplace_back(alloc);
+                auto& mesh = scene.meshes.back();
+                assign(mesh.vertices, mm.vertices());
+                assign(mesh.normals, mm.normals());
+                assign(mesh.indices, mm.indices());
+                assign(mesh.colors, mm.colors());
+                assign(mesh.uvs, mm.uvs());
+                mesh.texture = mm.texture();
+                assign(mesh.boneIndices, mm.boneIndices());
+                assign(mesh.boneWeights, mm.boneWeights());
+                if(const auto p = mm.packed()) {
+                    unpack(p, mesh);
+                } else if(mm.raw()->packed()) {
+                    // stream sizes do not match vertexCount: truncated or corrupt
+                    logger::error("[RKR] broken packed mesh ", i);
+                    return false;
                 }
-
-                mesh.colors.reserve(mm->colors()->size());
-                for(auto&& v : *(mm->colors())) {
-                    mesh.colors.push_back(v);
+                if(mm.interleaved()) {
+                    // kept as is, ready for a vertex buffer
+                    mesh.layout.stride = mm.stride();
+                    mesh.layout.attributes.reserve(mm.attributes().size());
+                    for(auto&& a : mm.attributes()) {
+                        mesh.layout.attributes.push_back({ static_cast<VERTEX_SEMANTIC>(a.semantic()), static_cast<VERTEX_FORMAT>(a.format()), a.offset() });
+                    }
+                    assign(mesh.vertexBlob, mm.vertexBlob());
                 }
-
-                mesh.uvs.reserve(mm->uvs()->size());
-                for(auto&& v : *(mm->uvs())) {
-                    mesh.uvs.push_back(v);
+                const auto b = mm.bounds();
+                if(!b.empty()) {
+                    copyBounds(b, mesh.bounds);
+                    std::copy(b.begin() + 6, b.begin() + 9, mesh.sphere.center);
+                    mesh.sphere.radius = b[9];
                 }
-                
-                mesh.texture = mm->texture()->str();
-                
-                mesh.boneIndices.reserve(mm->boneIndices()->size());
-                for(auto&& v : *(mm->boneIndices())) {
-                    mesh.boneIndices.push_back(v);
+                mesh.lods.reserve(mm.lodCount());
+                for(auto l = 0U; l < mm.lodCount(); l++) {
+                    mesh.lods.emplace_back(alloc);
+                    auto& lod = mesh.lods.back();
+                    if(!mm.lodIndices16(l).empty()) {
+                        assign(lod.indices, mm.lodIndices16(l));
+                    } else {
+                        assign(lod.indices, mm.lodIndices(l));
+                    }
+                    lod.vertexCount = mm.lodVertexCount(l);
+                    lod.error = mm.lodError(l);
                 }
-
-                mesh.boneWeights.reserve(mm->boneWeights()->size());
-                for(auto&& v : *(mm->boneWeights())) {
-                    mesh.boneWeights.push_back(v);
+                if(const auto ml = mm.meshlets()) {
+                    const auto r = make_view(ml->ranges());
+                    const auto b = make_view(ml->bounds());
+                    mesh.meshlets.resize(r.size() / 4);
+                    for(std::size_t k = 0; k < mesh.meshlets.size(); k++) {
+                        auto& m = mesh.meshlets[k];
+                        m.vertexOffset = r[k * 4];
+                        m.triangleOffset = r[k * 4 + 1];
+                        m.vertexCount = r[k * 4 + 2];
+                        m.triangleCount = r[k * 4 + 3];
+                        const auto f = b.begin() + k * 11;
+                        std::copy(f, f + 3, m.sphere.center);
+                        m.sphere.radius = f[3];
+                        std::copy(f + 4, f + 7, m.coneApex);
+                        std::copy(f + 7, f + 10, m.coneAxis);
+                        m.coneCutoff = f[10];
+                    }
+                    assign(mesh.meshletVertices, make_view(ml->vertices()));
+                    assign(mesh.meshletTriangles, make_view(ml->triangles()));
+                } else if(mm.raw()->meshlets()) {
+                    logger::error("[RKR] broken meshlets in mesh ", i);
+                    return false;
                 }
-
-                scene.meshes.push_back(std::move(mesh));
             }
             
-            auto a = s->animes();
-            scene.animes.reserve(a->size());
-            for(auto&& aa : *a) {
-                Anim anim;
-                auto af = aa->meshes();
-                anim.meshes.reserve(af->size());
-                for(auto&& aaa : *af) {
-                    AnimFrame anf;
-                    auto mm = aaa->meshMatrices();
-                    anf.meshMatrices.reserve(mm->size());
-                    for(auto&& mmm : *mm) {
-                        auto data = mmm->data();
-                        std::vector<float> v;
-                        v.reserve(data->size());
-                        for(auto&& d : *data) {
-                            v.push_back(d);
+            const auto ac = view.animCount();
+            scene.animes.reserve(scene.animes.size() + ac);
+            for(auto i = 0U; i < ac; i++) {
+                if(!view.hasAnim(i)) { continue; }
+                const auto aa = view.anim(i);
+                scene.animes.emplace_back(alloc);
+                auto& anim = scene.animes.back();
+                anim.meshes.reserve(aa.size());
+                for(auto k = 0U; k < aa.size(); k++) {
+                    const auto aaa = aa[k];
+                    anim.meshes.emplace_back(alloc);
+                    auto& anf = anim.meshes.back();
+                    copyTrack(aaa.meshTrack(), aaa.meshFrameCount(), [&](std::size_t f) { return aaa.meshMatrix(f); }, anf.meshMatrices);
+                    if(aaa.quantized()) {
+                        const auto q = aaa.quantizedBones();
+                        anf.boneMatrices.resize(q->frameCount(), q->boneCount() * 16);
+                        for(auto f = 0U; f < q->frameCount(); f++) {
+                            decodeBones(q, f, anf.boneMatrices.frame(f));
                         }
-                        anf.meshMatrices.push_back(std::move(v));
+                    } else {
+                        copyTrack(aaa.boneTrack(), aaa.boneFrameCount(), [&](std::size_t f) { return aaa.boneMatrices(f); }, anf.boneMatrices);
                     }
-                    auto bm = aaa->boneMatrices();
-                    anf.boneMatrices.reserve(bm->size());
-                    for(auto&& bmm : *bm) {
-                        auto data = bmm->data();
-                        std::vector<float> v;
-                        v.reserve(data->size());
-                        for(auto&& d : *data) {
-                            v.push_back(d);
+                    if(aaa.reduced()) {
+                        anf.frameCount = aaa.frameCount();
+                        assign(anf.meshKeys.frames, aaa.meshKeyFrames());
+                        assign(anf.meshKeys.keys, aaa.meshKeys());
+                        anf.boneKeys.reserve(aaa.boneKeyCount());
+                        for(auto b = 0U; b < aaa.boneKeyCount(); b++) {
+                            anf.boneKeys.emplace_back(alloc);
+                            assign(anf.boneKeys.back().frames, aaa.boneKeyFrames(b));
+                            assign(anf.boneKeys.back().keys, aaa.boneKeys(b));
                         }
-                        anf.boneMatrices.push_back(std::move(v));
                     }
-                    anim.meshes.push_back(std::move(anf));
+                    if(!aaa.clipBounds().empty()) {
+                        copyBounds(aaa.clipBounds(), anf.bounds);
+                    }
+                    const auto fb = aaa.frameBounds();
+                    anf.frameBounds.resize(fb.size() / 6);
+                    for(std::size_t f = 0; f < anf.frameBounds.size(); f++) {
+                        copyBounds(util::array_view<float>(fb.data() + f * 6, 6), anf.frameBounds[f]);
+                    }
                 }
-                scene.animes.push_back(std::move(anim));
             }
-            
             return true;
         }
     };
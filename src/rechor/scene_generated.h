@@ -10,8 +10,16 @@ namespace rechor {
 namespace model {
 
 struct Frame;
+struct Track;
+struct KeyTrack;
+struct QuantizedBones;
 struct AnimFrame;
 struct Anim;
+struct PackedMesh;
+struct VertexAttribute;
+struct VertexLayout;
+struct Lod;
+struct Meshlets;
 struct Mesh;
 struct Scene;
 
@@ -47,13 +55,184 @@ inline flatbuffers::Offset<Frame> CreateFrame(flatbuffers::FlatBufferBuilder &_f
   return builder_.Finish();
 }
 
+struct Track FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_FRAMECOUNT = 4,
+    VT_STRIDE = 6,
+    VT_DATA = 8,
+  };
+  uint32_t frameCount() const { return GetField<uint32_t>(VT_FRAMECOUNT, 0); }
+  uint32_t stride() const { return GetField<uint32_t>(VT_STRIDE, 0); }
+  const flatbuffers::Vector<float> *data() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_DATA); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_FRAMECOUNT) &&
+           VerifyField<uint32_t>(verifier, VT_STRIDE) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_DATA) &&
+           verifier.Verify(data()) &&
+           verifier.EndTable();
+  }
+};
+
+struct TrackBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_frameCount(uint32_t frameCount) { fbb_.AddElement<uint32_t>(Track::VT_FRAMECOUNT, frameCount, 0); }
+  void add_stride(uint32_t stride) { fbb_.AddElement<uint32_t>(Track::VT_STRIDE, stride, 0); }
+  void add_data(flatbuffers::Offset<flatbuffers::Vector<float>> data) { fbb_.AddOffset(Track::VT_DATA, data); }
+  TrackBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  TrackBuilder &operator=(const TrackBuilder &);
+  flatbuffers::Offset<Track> Finish() {
+    auto o = flatbuffers::Offset<Track>(fbb_.EndTable(start_, 3));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Track> CreateTrack(flatbuffers::FlatBufferBuilder &_fbb,
+   uint32_t frameCount = 0,
+   uint32_t stride = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> data = 0) {
+  TrackBuilder builder_(_fbb);
+  builder_.add_data(data);
+  builder_.add_stride(stride);
+  builder_.add_frameCount(frameCount);
+  return builder_.Finish();
+}
+
+struct KeyTrack FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_FRAMES = 4,
+    VT_KEYS = 6,
+  };
+  const flatbuffers::Vector<uint32_t> *frames() const { return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_FRAMES); }
+  const flatbuffers::Vector<float> *keys() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_KEYS); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_FRAMES) &&
+           verifier.Verify(frames()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_KEYS) &&
+           verifier.Verify(keys()) &&
+           verifier.EndTable();
+  }
+};
+
+struct KeyTrackBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_frames(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> frames) { fbb_.AddOffset(KeyTrack::VT_FRAMES, frames); }
+  void add_keys(flatbuffers::Offset<flatbuffers::Vector<float>> keys) { fbb_.AddOffset(KeyTrack::VT_KEYS, keys); }
+  KeyTrackBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  KeyTrackBuilder &operator=(const KeyTrackBuilder &);
+  flatbuffers::Offset<KeyTrack> Finish() {
+    auto o = flatbuffers::Offset<KeyTrack>(fbb_.EndTable(start_, 2));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<KeyTrack> CreateKeyTrack(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::Vector<uint32_t>> frames = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> keys = 0) {
+  KeyTrackBuilder builder_(_fbb);
+  builder_.add_keys(keys);
+  builder_.add_frames(frames);
+  return builder_.Finish();
+}
+
+struct QuantizedBones FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_FRAMECOUNT = 4,
+    VT_BONECOUNT = 6,
+    VT_ROTATIONS = 8,
+    VT_TRANSLATIONS = 10,
+    VT_SCALES = 12,
+    VT_RANGEMIN = 14,
+    VT_RANGEEXTENT = 16,
+  };
+  uint32_t frameCount() const { return GetField<uint32_t>(VT_FRAMECOUNT, 0); }
+  uint32_t boneCount() const { return GetField<uint32_t>(VT_BONECOUNT, 0); }
+  const flatbuffers::Vector<uint16_t> *rotations() const { return GetPointer<const flatbuffers::Vector<uint16_t> *>(VT_ROTATIONS); }
+  const flatbuffers::Vector<uint16_t> *translations() const { return GetPointer<const flatbuffers::Vector<uint16_t> *>(VT_TRANSLATIONS); }
+  const flatbuffers::Vector<float> *scales() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_SCALES); }
+  const flatbuffers::Vector<float> *rangeMin() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_RANGEMIN); }
+  const flatbuffers::Vector<float> *rangeExtent() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_RANGEEXTENT); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_FRAMECOUNT) &&
+           VerifyField<uint32_t>(verifier, VT_BONECOUNT) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_ROTATIONS) &&
+           verifier.Verify(rotations()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_TRANSLATIONS) &&
+           verifier.Verify(translations()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_SCALES) &&
+           verifier.Verify(scales()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_RANGEMIN) &&
+           verifier.Verify(rangeMin()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_RANGEEXTENT) &&
+           verifier.Verify(rangeExtent()) &&
+           verifier.EndTable();
+  }
+};
+
+struct QuantizedBonesBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_frameCount(uint32_t frameCount) { fbb_.AddElement<uint32_t>(QuantizedBones::VT_FRAMECOUNT, frameCount, 0); }
+  void add_boneCount(uint32_t boneCount) { fbb_.AddElement<uint32_t>(QuantizedBones::VT_BONECOUNT, boneCount, 0); }
+  void add_rotations(flatbuffers::Offset<flatbuffers::Vector<uint16_t>> rotations) { fbb_.AddOffset(QuantizedBones::VT_ROTATIONS, rotations); }
+  void add_translations(flatbuffers::Offset<flatbuffers::Vector<uint16_t>> translations) { fbb_.AddOffset(QuantizedBones::VT_TRANSLATIONS, translations); }
+  void add_scales(flatbuffers::Offset<flatbuffers::Vector<float>> scales) { fbb_.AddOffset(QuantizedBones::VT_SCALES, scales); }
+  void add_rangeMin(flatbuffers::Offset<flatbuffers::Vector<float>> rangeMin) { fbb_.AddOffset(QuantizedBones::VT_RANGEMIN, rangeMin); }
+  void add_rangeExtent(flatbuffers::Offset<flatbuffers::Vector<float>> rangeExtent) { fbb_.AddOffset(QuantizedBones::VT_RANGEEXTENT, rangeExtent); }
+  QuantizedBonesBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  QuantizedBonesBuilder &operator=(const QuantizedBonesBuilder &);
+  flatbuffers::Offset<QuantizedBones> Finish() {
+    auto o = flatbuffers::Offset<QuantizedBones>(fbb_.EndTable(start_, 7));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<QuantizedBones> CreateQuantizedBones(flatbuffers::FlatBufferBuilder &_fbb,
+   uint32_t frameCount = 0,
+   uint32_t boneCount = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint16_t>> rotations = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint16_t>> translations = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> scales = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> rangeMin = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> rangeExtent = 0) {
+  QuantizedBonesBuilder builder_(_fbb);
+  builder_.add_rangeExtent(rangeExtent);
+  builder_.add_rangeMin(rangeMin);
+  builder_.add_scales(scales);
+  builder_.add_translations(translations);
+  builder_.add_rotations(rotations);
+  builder_.add_boneCount(boneCount);
+  builder_.add_frameCount(frameCount);
+  return builder_.Finish();
+}
+
 struct AnimFrame FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   enum {
     VT_MESHMATRICES = 4,
     VT_BONEMATRICES = 6,
+    VT_FRAMECOUNT = 8,
+    VT_MESHKEYS = 10,
+    VT_BONEKEYS = 12,
+    VT_QUANTIZEDBONES = 14,
+    VT_MESHTRACK = 16,
+    VT_BONETRACK = 18,
+    VT_BOUNDS = 20,
+    VT_FRAMEBOUNDS = 22,
   };
   const flatbuffers::Vector<flatbuffers::Offset<Frame>> *meshMatrices() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Frame>> *>(VT_MESHMATRICES); }
   const flatbuffers::Vector<flatbuffers::Offset<Frame>> *boneMatrices() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Frame>> *>(VT_BONEMATRICES); }
+  uint32_t frameCount() const { return GetField<uint32_t>(VT_FRAMECOUNT, 0); }
+  const KeyTrack *meshKeys() const { return GetPointer<const KeyTrack *>(VT_MESHKEYS); }
+  const flatbuffers::Vector<flatbuffers::Offset<KeyTrack>> *boneKeys() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<KeyTrack>> *>(VT_BONEKEYS); }
+  const QuantizedBones *quantizedBones() const { return GetPointer<const QuantizedBones *>(VT_QUANTIZEDBONES); }
+  const Track *meshTrack() const { return GetPointer<const Track *>(VT_MESHTRACK); }
+  const Track *boneTrack() const { return GetPointer<const Track *>(VT_BONETRACK); }
+  const flatbuffers::Vector<float> *bounds() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_BOUNDS); }
+  const flatbuffers::Vector<float> *frameBounds() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_FRAMEBOUNDS); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, VT_MESHMATRICES) &&
@@ -62,6 +241,22 @@ struct AnimFrame FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            VerifyField<flatbuffers::uoffset_t>(verifier, VT_BONEMATRICES) &&
            verifier.Verify(boneMatrices()) &&
            verifier.VerifyVectorOfTables(boneMatrices()) &&
+           VerifyField<uint32_t>(verifier, VT_FRAMECOUNT) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_MESHKEYS) &&
+           verifier.VerifyTable(meshKeys()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_BONEKEYS) &&
+           verifier.Verify(boneKeys()) &&
+           verifier.VerifyVectorOfTables(boneKeys()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_QUANTIZEDBONES) &&
+           verifier.VerifyTable(quantizedBones()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_MESHTRACK) &&
+           verifier.VerifyTable(meshTrack()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_BONETRACK) &&
+           verifier.VerifyTable(boneTrack()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_BOUNDS) &&
+           verifier.Verify(bounds()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_FRAMEBOUNDS) &&
+           verifier.Verify(frameBounds()) &&
            verifier.EndTable();
   }
 };
@@ -71,18 +266,42 @@ struct AnimFrameBuilder {
   flatbuffers::uoffset_t start_;
   void add_meshMatrices(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Frame>>> meshMatrices) { fbb_.AddOffset(AnimFrame::VT_MESHMATRICES, meshMatrices); }
   void add_boneMatrices(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Frame>>> boneMatrices) { fbb_.AddOffset(AnimFrame::VT_BONEMATRICES, boneMatrices); }
+  void add_frameCount(uint32_t frameCount) { fbb_.AddElement<uint32_t>(AnimFrame::VT_FRAMECOUNT, frameCount, 0); }
+  void add_meshKeys(flatbuffers::Offset<KeyTrack> meshKeys) { fbb_.AddOffset(AnimFrame::VT_MESHKEYS, meshKeys); }
+  void add_boneKeys(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<KeyTrack>>> boneKeys) { fbb_.AddOffset(AnimFrame::VT_BONEKEYS, boneKeys); }
+  void add_quantizedBones(flatbuffers::Offset<QuantizedBones> quantizedBones) { fbb_.AddOffset(AnimFrame::VT_QUANTIZEDBONES, quantizedBones); }
+  void add_meshTrack(flatbuffers::Offset<Track> meshTrack) { fbb_.AddOffset(AnimFrame::VT_MESHTRACK, meshTrack); }
+  void add_boneTrack(flatbuffers::Offset<Track> boneTrack) { fbb_.AddOffset(AnimFrame::VT_BONETRACK, boneTrack); }
+  void add_bounds(flatbuffers::Offset<flatbuffers::Vector<float>> bounds) { fbb_.AddOffset(AnimFrame::VT_BOUNDS, bounds); }
+  void add_frameBounds(flatbuffers::Offset<flatbuffers::Vector<float>> frameBounds) { fbb_.AddOffset(AnimFrame::VT_FRAMEBOUNDS, frameBounds); }
   AnimFrameBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
   AnimFrameBuilder &operator=(const AnimFrameBuilder &);
   flatbuffers::Offset<AnimFrame> Finish() {
-    auto o = flatbuffers::Offset<AnimFrame>(fbb_.EndTable(start_, 2));
+    auto o = flatbuffers::Offset<AnimFrame>(fbb_.EndTable(start_, 10));
     return o;
   }
 };
 
 inline flatbuffers::Offset<AnimFrame> CreateAnimFrame(flatbuffers::FlatBufferBuilder &_fbb,
    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Frame>>> meshMatrices = 0,
-   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Frame>>> boneMatrices = 0) {
+   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Frame>>> boneMatrices = 0,
+   uint32_t frameCount = 0,
+   flatbuffers::Offset<KeyTrack> meshKeys = 0,
+   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<KeyTrack>>> boneKeys = 0,
+   flatbuffers::Offset<QuantizedBones> quantizedBones = 0,
+   flatbuffers::Offset<Track> meshTrack = 0,
+   flatbuffers::Offset<Track> boneTrack = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> bounds = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> frameBounds = 0) {
   AnimFrameBuilder builder_(_fbb);
+  builder_.add_frameBounds(frameBounds);
+  builder_.add_bounds(bounds);
+  builder_.add_boneTrack(boneTrack);
+  builder_.add_meshTrack(meshTrack);
+  builder_.add_quantizedBones(quantizedBones);
+  builder_.add_boneKeys(boneKeys);
+  builder_.add_meshKeys(meshKeys);
+  builder_.add_frameCount(frameCount);
   builder_.add_boneMatrices(boneMatrices);
   builder_.add_meshMatrices(meshMatrices);
   return builder_.Finish();
@@ -121,6 +340,258 @@ inline flatbuffers::Offset<Anim> CreateAnim(flatbuffers::FlatBufferBuilder &_fbb
   return builder_.Finish();
 }
 
+struct PackedMesh FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_VERTEXCOUNT = 4,
+    VT_BOUNDSMIN = 6,
+    VT_BOUNDSEXTENT = 8,
+    VT_POSITIONS = 10,
+    VT_NORMALS = 12,
+    VT_UVS = 14,
+    VT_COLORS = 16,
+    VT_BONEINDICES = 18,
+    VT_BONEWEIGHTS = 20,
+    VT_INDICES16 = 22,
+  };
+  uint32_t vertexCount() const { return GetField<uint32_t>(VT_VERTEXCOUNT, 0); }
+  const flatbuffers::Vector<float> *boundsMin() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_BOUNDSMIN); }
+  const flatbuffers::Vector<float> *boundsExtent() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_BOUNDSEXTENT); }
+  const flatbuffers::Vector<uint16_t> *positions() const { return GetPointer<const flatbuffers::Vector<uint16_t> *>(VT_POSITIONS); }
+  const flatbuffers::Vector<int16_t> *normals() const { return GetPointer<const flatbuffers::Vector<int16_t> *>(VT_NORMALS); }
+  const flatbuffers::Vector<uint16_t> *uvs() const { return GetPointer<const flatbuffers::Vector<uint16_t> *>(VT_UVS); }
+  const flatbuffers::Vector<uint8_t> *colors() const { return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_COLORS); }
+  const flatbuffers::Vector<uint8_t> *boneIndices() const { return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_BONEINDICES); }
+  const flatbuffers::Vector<uint8_t> *boneWeights() const { return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_BONEWEIGHTS); }
+  const flatbuffers::Vector<uint16_t> *indices16() const { return GetPointer<const flatbuffers::Vector<uint16_t> *>(VT_INDICES16); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_VERTEXCOUNT) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_BOUNDSMIN) &&
+           verifier.Verify(boundsMin()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_BOUNDSEXTENT) &&
+           verifier.Verify(boundsExtent()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_POSITIONS) &&
+           verifier.Verify(positions()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_NORMALS) &&
+           verifier.Verify(normals()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_UVS) &&
+           verifier.Verify(uvs()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_COLORS) &&
+           verifier.Verify(colors()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_BONEINDICES) &&
+           verifier.Verify(boneIndices()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_BONEWEIGHTS) &&
+           verifier.Verify(boneWeights()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_INDICES16) &&
+           verifier.Verify(indices16()) &&
+           verifier.EndTable();
+  }
+};
+
+struct PackedMeshBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_vertexCount(uint32_t vertexCount) { fbb_.AddElement<uint32_t>(PackedMesh::VT_VERTEXCOUNT, vertexCount, 0); }
+  void add_boundsMin(flatbuffers::Offset<flatbuffers::Vector<float>> boundsMin) { fbb_.AddOffset(PackedMesh::VT_BOUNDSMIN, boundsMin); }
+  void add_boundsExtent(flatbuffers::Offset<flatbuffers::Vector<float>> boundsExtent) { fbb_.AddOffset(PackedMesh::VT_BOUNDSEXTENT, boundsExtent); }
+  void add_positions(flatbuffers::Offset<flatbuffers::Vector<uint16_t>> positions) { fbb_.AddOffset(PackedMesh::VT_POSITIONS, positions); }
+  void add_normals(flatbuffers::Offset<flatbuffers::Vector<int16_t>> normals) { fbb_.AddOffset(PackedMesh::VT_NORMALS, normals); }
+  void add_uvs(flatbuffers::Offset<flatbuffers::Vector<uint16_t>> uvs) { fbb_.AddOffset(PackedMesh::VT_UVS, uvs); }
+  void add_colors(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> colors) { fbb_.AddOffset(PackedMesh::VT_COLORS, colors); }
+  void add_boneIndices(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> boneIndices) { fbb_.AddOffset(PackedMesh::VT_BONEINDICES, boneIndices); }
+  void add_boneWeights(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> boneWeights) { fbb_.AddOffset(PackedMesh::VT_BONEWEIGHTS, boneWeights); }
+  void add_indices16(flatbuffers::Offset<flatbuffers::Vector<uint16_t>> indices16) { fbb_.AddOffset(PackedMesh::VT_INDICES16, indices16); }
+  PackedMeshBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  PackedMeshBuilder &operator=(const PackedMeshBuilder &);
+  flatbuffers::Offset<PackedMesh> Finish() {
+    auto o = flatbuffers::Offset<PackedMesh>(fbb_.EndTable(start_, 10));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PackedMesh> CreatePackedMesh(flatbuffers::FlatBufferBuilder &_fbb,
+   uint32_t vertexCount = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> boundsMin = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> boundsExtent = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint16_t>> positions = 0,
+   flatbuffers::Offset<flatbuffers::Vector<int16_t>> normals = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint16_t>> uvs = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint8_t>> colors = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint8_t>> boneIndices = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint8_t>> boneWeights = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint16_t>> indices16 = 0) {
+  PackedMeshBuilder builder_(_fbb);
+  builder_.add_indices16(indices16);
+  builder_.add_boneWeights(boneWeights);
+  builder_.add_boneIndices(boneIndices);
+  builder_.add_colors(colors);
+  builder_.add_uvs(uvs);
+  builder_.add_normals(normals);
+  builder_.add_positions(positions);
+  builder_.add_boundsExtent(boundsExtent);
+  builder_.add_boundsMin(boundsMin);
+  builder_.add_vertexCount(vertexCount);
+  return builder_.Finish();
+}
+
+MANUALLY_ALIGNED_STRUCT(2) VertexAttribute FLATBUFFERS_FINAL_CLASS {
+ private:
+  uint8_t semantic_;
+  uint8_t format_;
+  uint16_t offset_;
+
+ public:
+  VertexAttribute(uint8_t _semantic, uint8_t _format, uint16_t _offset)
+    : semantic_(flatbuffers::EndianScalar(_semantic)), format_(flatbuffers::EndianScalar(_format)), offset_(flatbuffers::EndianScalar(_offset)) { }
+
+  uint8_t semantic() const { return flatbuffers::EndianScalar(semantic_); }
+  uint8_t format() const { return flatbuffers::EndianScalar(format_); }
+  uint16_t offset() const { return flatbuffers::EndianScalar(offset_); }
+};
+STRUCT_END(VertexAttribute, 4);
+
+struct VertexLayout FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_STRIDE = 4,
+    VT_ATTRIBUTES = 6,
+  };
+  uint32_t stride() const { return GetField<uint32_t>(VT_STRIDE, 0); }
+  const flatbuffers::Vector<const VertexAttribute *> *attributes() const { return GetPointer<const flatbuffers::Vector<const VertexAttribute *> *>(VT_ATTRIBUTES); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_STRIDE) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_ATTRIBUTES) &&
+           verifier.Verify(attributes()) &&
+           verifier.EndTable();
+  }
+};
+
+struct VertexLayoutBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_stride(uint32_t stride) { fbb_.AddElement<uint32_t>(VertexLayout::VT_STRIDE, stride, 0); }
+  void add_attributes(flatbuffers::Offset<flatbuffers::Vector<const VertexAttribute *>> attributes) { fbb_.AddOffset(VertexLayout::VT_ATTRIBUTES, attributes); }
+  VertexLayoutBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  VertexLayoutBuilder &operator=(const VertexLayoutBuilder &);
+  flatbuffers::Offset<VertexLayout> Finish() {
+    auto o = flatbuffers::Offset<VertexLayout>(fbb_.EndTable(start_, 2));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<VertexLayout> CreateVertexLayout(flatbuffers::FlatBufferBuilder &_fbb,
+   uint32_t stride = 0,
+   flatbuffers::Offset<flatbuffers::Vector<const VertexAttribute *>> attributes = 0) {
+  VertexLayoutBuilder builder_(_fbb);
+  builder_.add_attributes(attributes);
+  builder_.add_stride(stride);
+  return builder_.Finish();
+}
+
+struct Lod FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_INDICES = 4,
+    VT_INDICES16 = 6,
+    VT_VERTEXCOUNT = 8,
+    VT_ERROR = 10,
+  };
+  const flatbuffers::Vector<int32_t> *indices() const { return GetPointer<const flatbuffers::Vector<int32_t> *>(VT_INDICES); }
+  const flatbuffers::Vector<uint16_t> *indices16() const { return GetPointer<const flatbuffers::Vector<uint16_t> *>(VT_INDICES16); }
+  uint32_t vertexCount() const { return GetField<uint32_t>(VT_VERTEXCOUNT, 0); }
+  float error() const { return GetField<float>(VT_ERROR, 0.0f); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_INDICES) &&
+           verifier.Verify(indices()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_INDICES16) &&
+           verifier.Verify(indices16()) &&
+           VerifyField<uint32_t>(verifier, VT_VERTEXCOUNT) &&
+           VerifyField<float>(verifier, VT_ERROR) &&
+           verifier.EndTable();
+  }
+};
+
+struct LodBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_indices(flatbuffers::Offset<flatbuffers::Vector<int32_t>> indices) { fbb_.AddOffset(Lod::VT_INDICES, indices); }
+  void add_indices16(flatbuffers::Offset<flatbuffers::Vector<uint16_t>> indices16) { fbb_.AddOffset(Lod::VT_INDICES16, indices16); }
+  void add_vertexCount(uint32_t vertexCount) { fbb_.AddElement<uint32_t>(Lod::VT_VERTEXCOUNT, vertexCount, 0); }
+  void add_error(float error) { fbb_.AddElement<float>(Lod::VT_ERROR, error, 0.0f); }
+  LodBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  LodBuilder &operator=(const LodBuilder &);
+  flatbuffers::Offset<Lod> Finish() {
+    auto o = flatbuffers::Offset<Lod>(fbb_.EndTable(start_, 4));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Lod> CreateLod(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::Vector<int32_t>> indices = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint16_t>> indices16 = 0,
+   uint32_t vertexCount = 0,
+   float error = 0.0f) {
+  LodBuilder builder_(_fbb);
+  builder_.add_error(error);
+  builder_.add_vertexCount(vertexCount);
+  builder_.add_indices16(indices16);
+  builder_.add_indices(indices);
+  return builder_.Finish();
+}
+
+struct Meshlets FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_RANGES = 4,
+    VT_VERTICES = 6,
+    VT_TRIANGLES = 8,
+    VT_BOUNDS = 10,
+  };
+  const flatbuffers::Vector<uint32_t> *ranges() const { return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_RANGES); }
+  const flatbuffers::Vector<uint32_t> *vertices() const { return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_VERTICES); }
+  const flatbuffers::Vector<uint8_t> *triangles() const { return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_TRIANGLES); }
+  const flatbuffers::Vector<float> *bounds() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_BOUNDS); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_RANGES) &&
+           verifier.Verify(ranges()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_VERTICES) &&
+           verifier.Verify(vertices()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_TRIANGLES) &&
+           verifier.Verify(triangles()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_BOUNDS) &&
+           verifier.Verify(bounds()) &&
+           verifier.EndTable();
+  }
+};
+
+struct MeshletsBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_ranges(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> ranges) { fbb_.AddOffset(Meshlets::VT_RANGES, ranges); }
+  void add_vertices(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> vertices) { fbb_.AddOffset(Meshlets::VT_VERTICES, vertices); }
+  void add_triangles(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> triangles) { fbb_.AddOffset(Meshlets::VT_TRIANGLES, triangles); }
+  void add_bounds(flatbuffers::Offset<flatbuffers::Vector<float>> bounds) { fbb_.AddOffset(Meshlets::VT_BOUNDS, bounds); }
+  MeshletsBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  MeshletsBuilder &operator=(const MeshletsBuilder &);
+  flatbuffers::Offset<Meshlets> Finish() {
+    auto o = flatbuffers::Offset<Meshlets>(fbb_.EndTable(start_, 4));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Meshlets> CreateMeshlets(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::Vector<uint32_t>> ranges = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint32_t>> vertices = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint8_t>> triangles = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> bounds = 0) {
+  MeshletsBuilder builder_(_fbb);
+  builder_.add_bounds(bounds);
+  builder_.add_triangles(triangles);
+  builder_.add_vertices(vertices);
+  builder_.add_ranges(ranges);
+  return builder_.Finish();
+}
+
 struct Mesh FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   enum {
     VT_VERTICES = 4,
@@ -131,6 +602,12 @@ struct Mesh FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_TEXTURE = 14,
     VT_BONEINDICES = 16,
     VT_BONEWEIGHTS = 18,
+    VT_PACKED = 20,
+    VT_LAYOUT = 22,
+    VT_VERTEXBLOB = 24,
+    VT_BOUNDS = 26,
+    VT_LODS = 28,
+    VT_MESHLETS = 30,
   };
   const flatbuffers::Vector<float> *vertices() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_VERTICES); }
   const flatbuffers::Vector<float> *normals() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_NORMALS); }
@@ -140,6 +617,12 @@ struct Mesh FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const flatbuffers::String *texture() const { return GetPointer<const flatbuffers::String *>(VT_TEXTURE); }
   const flatbuffers::Vector<int32_t> *boneIndices() const { return GetPointer<const flatbuffers::Vector<int32_t> *>(VT_BONEINDICES); }
   const flatbuffers::Vector<float> *boneWeights() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_BONEWEIGHTS); }
+  const PackedMesh *packed() const { return GetPointer<const PackedMesh *>(VT_PACKED); }
+  const VertexLayout *layout() const { return GetPointer<const VertexLayout *>(VT_LAYOUT); }
+  const flatbuffers::Vector<uint8_t> *vertexBlob() const { return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_VERTEXBLOB); }
+  const flatbuffers::Vector<float> *bounds() const { return GetPointer<const flatbuffers::Vector<float> *>(VT_BOUNDS); }
+  const flatbuffers::Vector<flatbuffers::Offset<Lod>> *lods() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Lod>> *>(VT_LODS); }
+  const Meshlets *meshlets() const { return GetPointer<const Meshlets *>(VT_MESHLETS); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, VT_VERTICES) &&
@@ -158,6 +641,19 @@ struct Mesh FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            verifier.Verify(boneIndices()) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, VT_BONEWEIGHTS) &&
            verifier.Verify(boneWeights()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_PACKED) &&
+           verifier.VerifyTable(packed()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_LAYOUT) &&
+           verifier.VerifyTable(layout()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_VERTEXBLOB) &&
+           verifier.Verify(vertexBlob()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_BOUNDS) &&
+           verifier.Verify(bounds()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_LODS) &&
+           verifier.Verify(lods()) &&
+           verifier.VerifyVectorOfTables(lods()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_MESHLETS) &&
+           verifier.VerifyTable(meshlets()) &&
            verifier.EndTable();
   }
 };
@@ -173,10 +669,16 @@ struct MeshBuilder {
   void add_texture(flatbuffers::Offset<flatbuffers::String> texture) { fbb_.AddOffset(Mesh::VT_TEXTURE, texture); }
   void add_boneIndices(flatbuffers::Offset<flatbuffers::Vector<int32_t>> boneIndices) { fbb_.AddOffset(Mesh::VT_BONEINDICES, boneIndices); }
   void add_boneWeights(flatbuffers::Offset<flatbuffers::Vector<float>> boneWeights) { fbb_.AddOffset(Mesh::VT_BONEWEIGHTS, boneWeights); }
+  void add_packed(flatbuffers::Offset<PackedMesh> packed) { fbb_.AddOffset(Mesh::VT_PACKED, packed); }
+  void add_layout(flatbuffers::Offset<VertexLayout> layout) { fbb_.AddOffset(Mesh::VT_LAYOUT, layout); }
+  void add_vertexBlob(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> vertexBlob) { fbb_.AddOffset(Mesh::VT_VERTEXBLOB, vertexBlob); }
+  void add_bounds(flatbuffers::Offset<flatbuffers::Vector<float>> bounds) { fbb_.AddOffset(Mesh::VT_BOUNDS, bounds); }
+  void add_lods(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Lod>>> lods) { fbb_.AddOffset(Mesh::VT_LODS, lods); }
+  void add_meshlets(flatbuffers::Offset<Meshlets> meshlets) { fbb_.AddOffset(Mesh::VT_MESHLETS, meshlets); }
   MeshBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
   MeshBuilder &operator=(const MeshBuilder &);
   flatbuffers::Offset<Mesh> Finish() {
-    auto o = flatbuffers::Offset<Mesh>(fbb_.EndTable(start_, 8));
+    auto o = flatbuffers::Offset<Mesh>(fbb_.EndTable(start_, 14));
     return o;
   }
 };
@@ -189,8 +691,20 @@ inline flatbuffers::Offset<Mesh> CreateMesh(flatbuffers::FlatBufferBuilder &_fbb
    flatbuffers::Offset<flatbuffers::Vector<float>> uvs = 0,
    flatbuffers::Offset<flatbuffers::String> texture = 0,
    flatbuffers::Offset<flatbuffers::Vector<int32_t>> boneIndices = 0,
-   flatbuffers::Offset<flatbuffers::Vector<float>> boneWeights = 0) {
+   flatbuffers::Offset<flatbuffers::Vector<float>> boneWeights = 0,
+   flatbuffers::Offset<PackedMesh> packed = 0,
+   flatbuffers::Offset<VertexLayout> layout = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint8_t>> vertexBlob = 0,
+   flatbuffers::Offset<flatbuffers::Vector<float>> bounds = 0,
+   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Lod>>> lods = 0,
+   flatbuffers::Offset<Meshlets> meshlets = 0) {
   MeshBuilder builder_(_fbb);
+  builder_.add_meshlets(meshlets);
+  builder_.add_lods(lods);
+  builder_.add_bounds(bounds);
+  builder_.add_vertexBlob(vertexBlob);
+  builder_.add_layout(layout);
+  builder_.add_packed(packed);
   builder_.add_boneWeights(boneWeights);
   builder_.add_boneIndices(boneIndices);
   builder_.add_texture(texture);
@@ -245,9 +759,15 @@ inline flatbuffers::Offset<Scene> CreateScene(flatbuffers::FlatBufferBuilder &_f
 
 inline const rechor::model::Scene *GetScene(const void *buf) { return flatbuffers::GetRoot<rechor::model::Scene>(buf); }
 
-inline bool VerifySceneBuffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<rechor::model::Scene>(); }
+inline const char *SceneIdentifier() { return "RKR0"; }
+
+inline bool SceneBufferHasIdentifier(const void *buf) { return flatbuffers::BufferHasIdentifier(buf, SceneIdentifier()); }
+
+inline bool VerifySceneBuffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<rechor::model::Scene>(SceneIdentifier()); }
+
+inline const char *SceneExtension() { return "rkr"; }
 
-inline void FinishSceneBuffer(flatbuffers::FlatBufferBuilder &fbb, flatbuffers::Offset<rechor::model::Scene> root) { fbb.Finish(root); }
+inline void FinishSceneBuffer(flatbuffers::FlatBufferBuilder &fbb, flatbuffers::Offset<rechor::model::Scene> root) { fbb.Finish(root, SceneIdentifier()); }
 
 }  // namespace model
 }  // namespace rechor
@@ -0,0 +1,510 @@
+// rechor project
+// scene_view.hpp
+
+#ifndef _RHACT_RECHOR_SCENE_VIEW_HPP_
+#define _RHACT_RECHOR_SCENE_VIEW_HPP_
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+
+#include <lz4.h>
+
+#include "rechor.hpp"
+#include "stream_filter.hpp"
+#include "container.hpp"
+#include "../parallel.hpp"
+#include "../trace.hpp"
+
+namespace rhakt {
+namespace rechor {
+
+    template <typename T>
+    inline util::array_view<T> make_view(const flatbuffers::Vector<T>* v) {
+        return v ? util::array_view<T>(v->data(), v->size()) : util::array_view<T>();
+    }
+
+    /* zero-copy accessor of model::Mesh */
+    class MeshView {
+    private:
+        const model::Mesh* mesh_;
+        mutable const model::Meshlets* meshlets_;
+        mutable bool meshletsChecked_;
+
+        const model::Meshlets* checkMeshlets() const {
+            const auto m = mesh_->meshlets();
+            if(!m) { return nullptr; }
+            const auto r = make_view(m->ranges());
+            const auto b = make_view(m->bounds());
+            const auto vertices = make_view(m->vertices());
+            const auto triangles = make_view(m->triangles());
+            const auto n = r.size() / 4;
+            if(r.size() % 4 != 0 || b.size() != n * 11) { return nullptr; }
+            const std::size_t vn = mesh_->packed() ? mesh_->packed()->vertexCount() : vertexCount();
+            for(auto&& v : vertices) {
+                if(v >= vn) { return nullptr; }
+            }
+            for(std::size_t i = 0; i < n; i++) {
+                const std::size_t vo = r[i * 4], to = r[i * 4 + 1], v = r[i * 4 + 2], t = r[i * 4 + 3];
+                if(v > 256 || vo + v > vertices.size() || to + t * 3 > triangles.size()) { return nullptr; }
+                for(auto k = to; k < to + t * 3; k++) {
+                    if(triangles[k] >= v) { return nullptr; }
+                }
+            }
+            return m;
+        }
+
+    public:
+        explicit MeshView(const model::Mesh* mesh) : mesh_(mesh), meshlets_(nullptr), meshletsChecked_(false) {}
+
+        util::array_view<float> vertices() const { return make_view(mesh_->vertices()); }
+        util::array_view<float> normals() const { return make_view(mesh_->normals()); }
+        util::array_view<int32_t> indices() const { return make_view(mesh_->indices()); }
+        util::array_view<float> colors() const { return make_view(mesh_->colors()); }
+        util::array_view<float> uvs() const { return make_view(mesh_->uvs()); }
+        util::array_view<int32_t> boneIndices() const { return make_view(mesh_->boneIndices()); }
+        util::array_view<float> boneWeights() const { return make_view(mesh_->boneWeights()); }
+        const char* texture() const { return mesh_->texture() ? mesh_->texture()->c_str() : ""; }
+
+        /*-- packed streams (Importer::unpack decodes them), null if absent or inconsistent --*/
+        const model::PackedMesh* packed() const {
+            const auto p = mesh_->packed();
+            if(!p) { return nullptr; }
+            const std::size_t vc = p->vertexCount();
+            auto sized = [](std::size_t have, std::size_t want) { return have == 0 || have == want; };
+            const auto ok =
+                p->boundsMin() && p->boundsMin()->size() == 3 && p->boundsExtent() && p->boundsExtent()->size() == 3 &&
+                p->positions() && p->positions()->size() == vc * 3 &&
+                sized(make_view(p->normals()).size(), vc * 2) &&
+                sized(make_view(p->uvs()).size(), vc * 2) &&
+                sized(make_view(p->colors()).size(), vc * 4) &&
+                sized(make_view(p->boneIndices()).size(), vc * 4) &&
+                sized(make_view(p->boneWeights()).size(), vc * 4);
+            return ok ? p : nullptr;
+        }
+        util::array_view<uint16_t> indices16() const { return packed() ? make_view(mesh_->packed()->indices16()) : util::array_view<uint16_t>(); }
+
+        /*-- interleaved vertices, 16 byte aligned when the file is mapped or decompressed --*/
+        bool interleaved() const { return mesh_->layout() && mesh_->vertexBlob(); }
+        uint stride() const { return mesh_->layout() ? mesh_->layout()->stride() : 0; }
+        std::size_t vertexCount() const { return stride() ? vertexBlob().size() / stride() : vertices().size() / 3; }
+        util::array_view<uint8_t> vertexBlob() const {
+            const auto blob = make_view(mesh_->vertexBlob());
+            assert((blob.empty() || reinterpret_cast<std::uintptr_t>(blob.data()) % 16 == 0) && "vertexBlob is not 16 byte aligned");
+            return blob;
+        }
+        util::array_view<model::VertexAttribute> attributes() const {
+            const auto a = mesh_->layout() ? mesh_->layout()->attributes() : nullptr;
+            return a ? util::array_view<model::VertexAttribute>(reinterpret_cast<const model::VertexAttribute*>(a->Data()), a->size()) : util::array_view<model::VertexAttribute>();
+        }
+
+        /*-- bind pose box min(3) max(3), sphere center(3) radius; empty if absent --*/
+        util::array_view<float> bounds() const {
+            const auto b = make_view(mesh_->bounds());
+            return b.size() == 10 ? b : util::array_view<float>();
+        }
+
+        /*-- levels of detail, finest first (see simplifier.hpp) --*/
+        std::size_t lodCount() const { return mesh_->lods() ? mesh_->lods()->size() : 0; }
+        util::array_view<int32_t> lodIndices(std::size_t i) const { return make_view(lod(i)->indices()); }
+        // packed meshes below 65536 vertices
+        util::array_view<uint16_t> lodIndices16(std::size_t i) const { return make_view(lod(i)->indices16()); }
+        uint lodVertexCount(std::size_t i) const { return lod(i)->vertexCount(); }
+        float lodError(std::size_t i) const { return lod(i)->error(); }
+        const model::Lod* lod(std::size_t i) const { return mesh_->lods()->Get(static_cast<flatbuffers::uoffset_t>(i)); }
+
+        /*
+         * meshlets (see meshlet.hpp), null if absent or inconsistent: a range
+         * outside its arrays, a vertex past the mesh or a local index past its
+         * meshlet. checked on the first call of a view.
+         */
+        const model::Meshlets* meshlets() const {
+            if(!meshletsChecked_) {
+                meshlets_ = checkMeshlets();
+                meshletsChecked_ = true;
+            }
+            return meshlets_;
+        }
+        std::size_t meshletCount() const { return meshlets() ? meshlets_->ranges()->size() / 4 : 0; }
+
+        const model::Mesh* raw() const { return mesh_; }
+    };
+
+    /* zero-copy accessor of model::AnimFrame (tracks of one mesh) */
+    class AnimFrameView {
+    private:
+        const model::AnimFrame* frame_;
+
+        // null unless the data holds frameCount * stride floats
+        static const model::Track* valid(const model::Track* t) {
+            return t && t->stride() > 0 && t->data() && t->data()->size() / t->stride() >= t->frameCount() ? t : nullptr;
+        }
+
+        static std::size_t count(const model::Track* t, const flatbuffers::Vector<flatbuffers::Offset<model::Frame>>* legacy) {
+            if(valid(t)) { return t->frameCount(); }
+            return legacy ? legacy->size() : 0;
+        }
+
+        static util::array_view<float> at(const model::Track* t, const flatbuffers::Vector<flatbuffers::Offset<model::Frame>>* legacy, std::size_t i) {
+            if(valid(t)) { return util::array_view<float>(t->data()->data() + i * t->stride(), t->stride()); }
+            return make_view(legacy->Get(static_cast<flatbuffers::uoffset_t>(i))->data());
+        }
+
+        static util::array_view<float> all(const model::Track* t) {
+            return valid(t) ? util::array_view<float>(t->data()->data(), static_cast<std::size_t>(t->frameCount()) * t->stride()) : util::array_view<float>();
+        }
+
+    public:
+        explicit AnimFrameView(const model::AnimFrame* frame) : frame_(frame) {}
+
+        std::size_t meshFrameCount() const { return count(frame_->meshTrack(), frame_->meshMatrices()); }
+        std::size_t boneFrameCount() const { return count(frame_->boneTrack(), frame_->boneMatrices()); }
+        // 4x4 matrix
+        util::array_view<float> meshMatrix(std::size_t frame) const { return at(frame_->meshTrack(), frame_->meshMatrices(), frame); }
+        // 4x4 matrix * bones
+        util::array_view<float> boneMatrices(std::size_t frame) const { return at(frame_->boneTrack(), frame_->boneMatrices(), frame); }
+
+        /*-- whole tracks, frame after frame (empty for legacy files, which store a table per frame) --*/
+        util::array_view<float> meshTrack() const { return all(frame_->meshTrack()); }
+        util::array_view<float> boneTrack() const { return all(frame_->boneTrack()); }
+        uint boneStride() const { return valid(frame_->boneTrack()) ? frame_->boneTrack()->stride() : 0; }
+
+        /*-- reduced tracks (see keyframe_reducer.hpp) --*/
+        uint frameCount() const { return frame_->frameCount(); }
+        bool reduced() const { return frame_->frameCount() > 0; }
+        std::size_t boneKeyCount() const { return frame_->boneKeys() ? frame_->boneKeys()->size() : 0; }
+        util::array_view<uint> meshKeyFrames() const { return frame_->meshKeys() ? make_view(frame_->meshKeys()->frames()) : util::array_view<uint>(); }
+        util::array_view<float> meshKeys() const { return frame_->meshKeys() ? make_view(frame_->meshKeys()->keys()) : util::array_view<float>(); }
+        util::array_view<uint> boneKeyFrames(std::size_t bone) const { return make_view(frame_->boneKeys()->Get(static_cast<flatbuffers::uoffset_t>(bone))->frames()); }
+        util::array_view<float> boneKeys(std::size_t bone) const { return make_view(frame_->boneKeys()->Get(static_cast<flatbuffers::uoffset_t>(bone))->keys()); }
+
+        /*-- quantized bones (Importer::decodeBones rebuilds the matrices) --*/
+        bool quantized() const {
+            // the verifier checks structure only, sizes are checked here
+            const auto q = frame_->quantizedBones();
+            if(!q || !q->rotations() || !q->translations() || !q->rangeMin() || !q->rangeExtent()) { return false; }
+            const auto n = static_cast<std::size_t>(q->frameCount()) * q->boneCount();
+            return q->rotations()->size() >= n * 3 && q->translations()->size() >= n * 3 &&
+                (!q->scales() || q->scales()->size() >= n) &&
+                q->rangeMin()->size() >= q->boneCount() * 3 && q->rangeExtent()->size() >= q->boneCount() * 3;
+        }
+        const model::QuantizedBones* quantizedBones() const { return frame_->quantizedBones(); }
+
+        /*-- boxes around the animated mesh, min(3) max(3) each; empty if absent --*/
+        util::array_view<float> clipBounds() const {
+            const auto b = make_view(frame_->bounds());
+            return b.size() == 6 ? b : util::array_view<float>();
+        }
+        util::array_view<float> frameBounds() const {
+            const auto b = make_view(frame_->frameBounds());
+            return b.size() % 6 == 0 ? b : util::array_view<float>();
+        }
+
+        const model::AnimFrame* raw() const { return frame_; }
+    };
+
+    /* zero-copy accessor of model::Anim */
+    class AnimView {
+    private:
+        const model::Anim* anim_;
+
+    public:
+        explicit AnimView(const model::Anim* anim) : anim_(anim) {}
+
+        std::size_t size() const { return anim_->meshes() ? anim_->meshes()->size() : 0; }
+        AnimFrameView operator[](std::size_t i) const {
+            return AnimFrameView(anim_->meshes()->Get(static_cast<flatbuffers::uoffset_t>(i)));
+        }
+
+        const model::Anim* raw() const { return anim_; }
+    };
+
+    /* meshes and anims to load (chunked files skip the rest entirely) */
+    struct Selection {
+        bool allMeshes;
+        bool allAnimes;
+        std::vector<uint> meshes;
+        std::vector<uint> animes;
+
+        Selection() : allMeshes(true), allAnimes(true) {}
+
+        static Selection only(std::vector<uint> meshes, std::vector<uint> animes) {
+            Selection s;
+            s.allMeshes = s.allAnimes = false;
+            s.meshes = std::move(meshes);
+            s.animes = std::move(animes);
+            return s;
+        }
+
+        bool hasMesh(uint i) const { return allMeshes || std::find(meshes.begin(), meshes.end(), i) != meshes.end(); }
+        bool hasAnim(uint i) const { return allAnimes || std::find(animes.begin(), animes.end(), i) != animes.end(); }
+    };
+
+    /*
+     * read-only view of a .rkr file.
+     * uncompressed files are memory mapped and accessed in place,
+     * compressed files are decompressed once into buffers owned by the view.
+     * every view returned is valid until close() or destruction.
+     */
+    class SceneView : private util::Noncopyable {
+    private:
+        util::MappedFile file_;
+        std::unique_ptr<char[]> buffer_;
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        const model::Scene* scene_;
+        std::vector<const model::Mesh*> meshes_;
+        std::vector<const model::Anim*> animes_;
+        uint threads_;
+        bool open_;
+        bool mapped_;
+
+        template <typename T>
+        static bool verify(const char* data, std::size_t size, const char* identifier) {
+            RECHOR_TRACE_SCOPE("verify");
+            RECHOR_TRACE_ARG("bytes", size);
+            flatbuffers::Verifier verifier(reinterpret_cast<const uint8_t*>(data), size);
+            const auto ok = verifier.VerifyBuffer<T>(identifier);
+            if(!ok) {
+                logger::error("[Flatbuffers] verify error");
+            }
+            return ok;
+        }
+
+        static bool decompress(const char* src, std::size_t size, char* dst, std::size_t rawSize) {
+            RECHOR_TRACE_SCOPE("lz4");
+            RECHOR_TRACE_ARG("compressed", size);
+            RECHOR_TRACE_ARG("bytes", rawSize);
+            const auto outputsize = LZ4_decompress_safe(src, dst, static_cast<int>(size), static_cast<int>(rawSize));
+            if(outputsize < 0 || static_cast<std::size_t>(outputsize) != rawSize) {
+                logger::error("[LZ4] decompress error");
+                return false;
+            }
+            return true;
+        }
+
+        // headerless LZ4: the decoded size is unknown, grow until it fits
+        bool decompressLegacy(const char* src, std::size_t size) {
+            // LZ4 cannot expand data by more than 255x
+            const auto limit = size * 255;
+            for(auto capacity = size * 4; ; capacity = std::min(capacity * 4, limit)) {
+                buffer_.reset(new char[capacity]);
+                const auto outputsize = LZ4_decompress_safe(src, buffer_.get(), static_cast<int>(size), static_cast<int>(capacity));
+                if(outputsize > 0) {
+                    return verify<model::Scene>(buffer_.get(), outputsize, nullptr);
+                }
+                if(capacity >= limit) { break; }
+            }
+            logger::error("[LZ4] decompress error");
+            return false;
+        }
+
+        void setScene(const char* root, const Selection& sel) {
+            scene_ = model::GetScene(root);
+            const auto mc = scene_->meshes() ? scene_->meshes()->size() : 0;
+            const auto ac = scene_->animes() ? scene_->animes()->size() : 0;
+            meshes_.assign(mc, nullptr);
+            animes_.assign(ac, nullptr);
+            for(auto i = 0U; i < mc; i++) {
+                if(sel.hasMesh(i)) { meshes_[i] = scene_->meshes()->Get(i); }
+            }
+            for(auto i = 0U; i < ac; i++) {
+                if(sel.hasAnim(i)) { animes_[i] = scene_->animes()->Get(i); }
+            }
+        }
+
+        bool openSingle(const FileHeader& h, const char* payload, bool trusted, const Selection& sel) {
+            if(!container::checkPayload(h, payload, static_cast<std::size_t>(h.payloadSize))) { return false; }
+
+            const char* root = payload;
+            if(static_cast<CODEC>(h.codec) == CODEC::LZ4) {
+                buffer_.reset(new char[static_cast<std::size_t>(h.rawSize)]);
+                if(!decompress(payload, static_cast<std::size_t>(h.payloadSize), buffer_.get(), static_cast<std::size_t>(h.rawSize))) { return false; }
+                root = buffer_.get();
+            } else if(h.rawSize != h.payloadSize) {
+                logger::error("[RKR] size mismatch");
+                return false;
+            } else {
+                mapped_ = true;
+            }
+            // the checksum already rejected damaged files
+            if(!trusted && !verify<model::Scene>(root, static_cast<std::size_t>(h.rawSize), model::SceneIdentifier())) { return false; }
+            if(h.flags & container::FLAG_FILTERED) {
+                if(mapped_) {
+                    logger::error("[RKR] filtered payload must be compressed");
+                    return false;
+                }
+                RECHOR_TRACE_SCOPE("unfilter");
+                RECHOR_TRACE_ARG("bytes", h.rawSize);
+                filter::StreamFilter(false).apply(model::GetScene(root));
+            }
+            setScene(root, sel);
+            return true;
+        }
+
+        bool openChunked(const FileHeader& h, const char* payload, bool trusted, const Selection& sel) {
+            const auto size = static_cast<std::size_t>(h.payloadSize);
+            std::uint32_t counts[2];
+            if(size < sizeof(counts)) {
+                logger::error("[RKR] broken directory");
+                return false;
+            }
+            std::memcpy(counts, payload, sizeof(counts));
+            const auto entries = static_cast<std::size_t>(counts[0]) + counts[1];
+            const auto dirsize = container::directorySize(entries);
+            if(dirsize > size || !container::checkPayload(h, payload, dirsize)) { return false; }
+
+            std::vector<ChunkEntry> dir(entries);
+            std::memcpy(dir.data(), payload + sizeof(counts), entries * sizeof(ChunkEntry));
+
+            meshes_.assign(counts[0], nullptr);
+            animes_.assign(counts[1], nullptr);
+            blocks_.resize(entries);
+
+            /* pick the requested blocks */
+            std::vector<std::size_t> jobs;
+            for(std::size_t i = 0; i < entries; i++) {
+                const auto& e = dir[i];
+                const auto mesh = i < counts[0];
+                const auto index = static_cast<uint>(mesh ? i : i - counts[0]);
+                if(e.kind != static_cast<std::uint8_t>(mesh ? CHUNK_KIND::MESH : CHUNK_KIND::ANIM) || e.index != index
+                    || e.offset > size || e.size > size - e.offset || e.codec > static_cast<std::uint8_t>(CODEC::LZ4)) {
+                    logger::error("[RKR] broken directory");
+                    return false;
+                }
+                if(mesh ? sel.hasMesh(index) : sel.hasAnim(index)) {
+                    jobs.push_back(i);
+                    if(static_cast<CODEC>(e.codec) == CODEC::NONE) { mapped_ = true; }
+                }
+            }
+
+            std::atomic<bool> ok(true);
+            util::parallel_for(jobs.size(), threads_, [&](std::size_t j) {
+                const auto i = jobs[j];
+                const auto& e = dir[i];
+                const auto src = payload + e.offset;
+                RECHOR_TRACE_SCOPE(i < counts[0] ? "mesh block" : "anim block");
+                RECHOR_TRACE_ARG("index", i < counts[0] ? i : i - counts[0]);
+                if(util::xxh64(src, static_cast<std::size_t>(e.size)) != e.checksum) {
+                    logger::error("[RKR] block checksum mismatch");
+                    ok = false;
+                    return;
+                }
+                const char* root = src;
+                if(static_cast<CODEC>(e.codec) == CODEC::LZ4) {
+                    blocks_[i].reset(new char[static_cast<std::size_t>(e.rawSize)]);
+                    if(!decompress(src, static_cast<std::size_t>(e.size), blocks_[i].get(), static_cast<std::size_t>(e.rawSize))) {
+                        ok = false;
+                        return;
+                    }
+                    root = blocks_[i].get();
+                }
+                // only decompressed blocks are filtered, mapped ones are read as is
+                const auto unfilter = (h.flags & container::FLAG_FILTERED) && root != src;
+                filter::StreamFilter sf(false);
+                if(i < counts[0]) {
+                    if(!trusted && !verify<model::Mesh>(root, static_cast<std::size_t>(e.rawSize), nullptr)) { ok = false; return; }
+                    meshes_[i] = flatbuffers::GetRoot<model::Mesh>(root);
+                    if(unfilter) {
+                        RECHOR_TRACE_SCOPE("unfilter");
+                        sf.apply(meshes_[i]);
+                    }
+                } else {
+                    if(!trusted && !verify<model::Anim>(root, static_cast<std::size_t>(e.rawSize), nullptr)) { ok = false; return; }
+                    animes_[i - counts[0]] = flatbuffers::GetRoot<model::Anim>(root);
+                    if(unfilter) {
+                        RECHOR_TRACE_SCOPE("unfilter");
+                        sf.apply(animes_[i - counts[0]]);
+                    }
+                }
+            });
+            return ok;
+        }
+
+        bool openContainer(const char* data, std::size_t size, bool trusted, const Selection& sel) {
+            FileHeader h;
+            if(!container::readHeader(data, size, h)) { return false; }
+            const auto payload = data + sizeof(FileHeader);
+            if(h.flags & container::FLAG_CHUNKED) {
+                return openChunked(h, payload, trusted, sel);
+            }
+            return openSingle(h, payload, trusted, sel);
+        }
+
+    public:
+        explicit SceneView() : scene_(nullptr), threads_(1), open_(false), mapped_(false) {}
+        virtual ~SceneView() {}
+
+        // workers used to decode chunked files (0: hardware threads)
+        void setThreads(uint threads) { threads_ = threads; }
+
+        // trusted: skip the flatbuffers verifier for files with a valid header
+        bool open(const char* filename, bool trusted = false, const Selection& sel = Selection()) {
+            RECHOR_TRACE_SCOPE("SceneView::open");
+            close();
+            {
+                RECHOR_TRACE_SCOPE("map file");
+                if(!file_.open(filename)) {
+                    logger::error("[SceneView] open error");
+                    return false;
+                }
+                RECHOR_TRACE_ARG("bytes", file_.size());
+            }
+
+            const auto data = file_.data();
+            const auto size = file_.size();
+            bool ok;
+            if(container::hasHeader(data, size)) {
+                ok = openContainer(data, size, trusted, sel);
+            } else if(size >= 8 && model::SceneBufferHasIdentifier(data)) {
+                /* legacy plain flatbuffer */
+                ok = mapped_ = verify<model::Scene>(data, size, model::SceneIdentifier());
+                if(ok) { setScene(data, sel); }
+            } else {
+                /* legacy headerless LZ4 */
+                ok = decompressLegacy(data, size);
+                if(ok) { setScene(buffer_.get(), sel); }
+            }
+            open_ = ok;
+            if(!ok) {
+                close();
+            } else if(!mapped_) {
+                file_.close();
+            }
+            return ok;
+        }
+
+        void close() {
+            open_ = false;
+            mapped_ = false;
+            scene_ = nullptr;
+            meshes_.clear();
+            animes_.clear();
+            blocks_.clear();
+            buffer_.reset();
+            file_.close();
+        }
+
+        bool is_open() const { return open_; }
+        // true if some data is read directly from the mapped file
+        bool mapped() const { return mapped_; }
+
+        // counts include meshes/anims not selected on open
+        std::size_t meshCount() const { return meshes_.size(); }
+        bool hasMesh(std::size_t i) const { return meshes_[i] != nullptr; }
+        MeshView mesh(std::size_t i) const { return MeshView(meshes_[i]); }
+
+        std::size_t animCount() const { return animes_.size(); }
+        bool hasAnim(std::size_t i) const { return animes_[i] != nullptr; }
+        AnimView anim(std::size_t i) const { return AnimView(animes_[i]); }
+
+        // nullptr for chunked files
+        const model::Scene* raw() const { return scene_; }
+    };
+
+}} // namespace rhakt::rechor
+
+#endif
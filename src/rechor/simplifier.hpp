@@ -0,0 +1,524 @@
+// rechor project
+// simplifier.hpp
+//
+// levels of detail by quadric error edge collapse (Garland, Heckbert).
+// vertices only ever move onto a neighbour, so every level is an index
+// buffer over the vertex streams of the full mesh.
+
+#ifndef _RHACT_RECHOR_SIMPLIFIER_HPP_
+#define _RHACT_RECHOR_SIMPLIFIER_HPP_
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "rechor.hpp"
+#include "mesh_optimizer.hpp"
+
+namespace rhakt {
+namespace rechor {
+
+    /* target ratios of a LOD chain and the error allowed on the way */
+    struct LodSettings {
+        std::vector<float> ratios;  // triangles kept per level relative to the full mesh, descending
+        float maxError;             // deviation allowed, relative to the mesh extent (levels stop short of their ratio there)
+        float weightScale;          // a bone weight difference of 1 costs like moving this fraction of the extent (about a limb)
+
+        LodSettings(std::vector<float> r = { 0.5f, 0.25f, 0.125f }, float e = 0.05f, float w = 0.1f)
+            : ratios(std::move(r)), maxError(e), weightScale(w) {}
+    };
+
+    namespace simplify {
+
+        namespace detail {
+
+            enum struct VERTEX_KIND : uchar {
+                MANIFOLD = 0,   // interior, may move onto any neighbour
+                BORDER = 1,     // on an open edge, moves along it only
+                SEAM = 2,       // one of two split vertices (uv, normal...), moves along the seam with its twin
+                LOCKED = 3      // corners, seam ends, non-manifold: never moves
+            };
+
+            static const int NONE = -1;     // no open edge
+            static const int MANY = -2;     // several open edges
+            static const float BORDER_WEIGHT = 10.f;
+            static const float MIN_TURN = 0.25f;    // cosine
+
+            // symmetric 4x4 plane quadric and the weight (area) summed into it
+            struct Quadric {
+                double a2, b2, c2, d2, ab, ac, ad, bc, bd, cd, w;
+
+                Quadric() : a2(0), b2(0), c2(0), d2(0), ab(0), ac(0), ad(0), bc(0), bd(0), cd(0), w(0) {}
+
+                // plane a x + b y + c z + d = 0, (a, b, c) unit
+                Quadric(double a, double b, double c, double d, double weight)
+                    : a2(a * a * weight), b2(b * b * weight), c2(c * c * weight), d2(d * d * weight),
+                      ab(a * b * weight), ac(a * c * weight), ad(a * d * weight),
+                      bc(b * c * weight), bd(b * d * weight), cd(c * d * weight), w(weight) {}
+
+                void add(const Quadric& q) {
+                    a2 += q.a2; b2 += q.b2; c2 += q.c2; d2 += q.d2;
+                    ab += q.ab; ac += q.ac; ad += q.ad;
+                    bc += q.bc; bd += q.bd; cd += q.cd;
+                    w += q.w;
+                }
+
+                // mean squared distance of p to the planes
+                double error(const float* p) const {
+                    const double x = p[0], y = p[1], z = p[2];
+                    const auto r = a2 * x * x + b2 * y * y + c2 * z * z
+                        + 2 * (ab * x * y + ac * x * z + bc * y * z)
+                        + 2 * (ad * x + bd * y + cd * z) + d2;
+                    return w > 0 ? std::fabs(r) / w : 0.0;
+                }
+            };
+
+            inline void sub3(const float* a, const float* b, float* r) {
+                r[0] = a[0] - b[0]; r[1] = a[1] - b[1]; r[2] = a[2] - b[2];
+            }
+
+            inline void cross3(const float* a, const float* b, float* r) {
+                r[0] = a[1] * b[2] - a[2] * b[1];
+                r[1] = a[2] * b[0] - a[0] * b[2];
+                r[2] = a[0] * b[1] - a[1] * b[0];
+            }
+
+            inline float dot3(const float* a, const float* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+            // unnormalized normal of (a, b, c)
+            inline void normal(const float* a, const float* b, const float* c, float* n) {
+                float e1[3], e2[3];
+                sub3(b, a, e1);
+                sub3(c, a, e2);
+                cross3(e1, e2, n);
+            }
+
+            // directed edges, sorted for lookup
+            struct EdgeSet {
+                std::vector<std::uint64_t> keys;
+
+                static std::uint64_t key(int a, int b) { return static_cast<std::uint64_t>(static_cast<std::uint32_t>(a)) << 32 | static_cast<std::uint32_t>(b); }
+
+                void add(int a, int b) { keys.push_back(key(a, b)); }
+                void build() { std::sort(keys.begin(), keys.end()); }
+                bool has(int a, int b) const { return std::binary_search(keys.begin(), keys.end(), key(a, b)); }
+            };
+
+            /*
+             * state of one simplification, shared by all levels of a chain so the
+             * quadrics and the error keep accumulating from level to level.
+             */
+            class Simplifier {
+            private:
+                const Mesh& mesh_;
+                const std::size_t vc_;
+                const float* normals_;          // null without a normal stream
+                std::vector<int> indices_;
+                std::vector<int> remap_;        // first vertex at the same position
+                std::vector<int> wedge_;        // next vertex at the same position (circular)
+                std::vector<int> openOut_;      // target of the open edge leaving a vertex, or NONE/MANY
+                std::vector<int> openIn_;
+                std::vector<VERTEX_KIND> kind_;
+                std::vector<Quadric> quadrics_; // per position (remap_)
+                double weightScale_;            // squared, in model units
+                float error_;                   // largest collapse distance so far, model units
+
+                struct Collapse {
+                    int v0;
+                    int v1;
+                    float cost;     // squared distance, bone weight penalty included
+                    float distance; // squared distance alone
+                };
+
+                const float* position(int v) const { return &mesh_.vertices[static_cast<std::size_t>(v) * 3]; }
+
+                void buildRemap() {
+                    std::vector<int> order(vc_);
+                    std::iota(order.begin(), order.end(), 0);
+                    std::sort(order.begin(), order.end(), [&](int a, int b) {
+                        const auto pa = position(a), pb = position(b);
+                        if(pa[0] != pb[0]) { return pa[0] < pb[0]; }
+                        if(pa[1] != pb[1]) { return pa[1] < pb[1]; }
+                        if(pa[2] != pb[2]) { return pa[2] < pb[2]; }
+                        return a < b;
+                    });
+                    remap_.resize(vc_);
+                    wedge_.resize(vc_);
+                    for(std::size_t i = 0; i < vc_;) {
+                        auto j = i + 1;
+                        while(j < vc_ && std::equal(position(order[i]), position(order[i]) + 3, position(order[j]))) { j++; }
+                        for(auto k = i; k < j; k++) {
+                            remap_[order[k]] = order[i];
+                            wedge_[order[k]] = order[k + 1 < j ? k + 1 : i];
+                        }
+                        i = j;
+                    }
+                }
+
+                static void link(std::vector<int>& open, int v, int to) {
+                    open[v] = open[v] == NONE || open[v] == to ? to : MANY;
+                }
+
+                /*
+                 * open edges (no opposite half edge between the same vertices) and
+                 * vertex kinds; borders gets the open edges without a twin across a
+                 * seam, as (first index of the triangle, corner)
+                 */
+                void classify(std::vector<std::pair<std::size_t, int>>& borders) {
+                    EdgeSet vertexEdges, positionEdges;
+                    for(std::size_t i = 0; i < indices_.size(); i += 3) {
+                        for(int e = 0; e < 3; e++) {
+                            const auto a = indices_[i + e], b = indices_[i + (e + 1) % 3];
+                            vertexEdges.add(a, b);
+                            positionEdges.add(remap_[a], remap_[b]);
+                        }
+                    }
+                    vertexEdges.build();
+                    positionEdges.build();
+
+                    openOut_.assign(vc_, NONE);
+                    openIn_.assign(vc_, NONE);
+                    std::vector<uchar> border(vc_, 0);  // has an open edge without a twin across a seam
+                    for(std::size_t i = 0; i < indices_.size(); i += 3) {
+                        for(int e = 0; e < 3; e++) {
+                            const auto a = indices_[i + e], b = indices_[i + (e + 1) % 3];
+                            if(vertexEdges.has(b, a)) { continue; }
+                            link(openOut_, a, b);
+                            link(openIn_, b, a);
+                            if(!positionEdges.has(remap_[b], remap_[a])) {
+                                border[a] = border[b] = 1;
+                                borders.emplace_back(i, e);
+                            }
+                        }
+                    }
+
+                    kind_.assign(vc_, VERTEX_KIND::LOCKED);
+                    for(std::size_t v = 0; v < vc_; v++) {
+                        const auto out = openOut_[v], in = openIn_[v];
+                        if(wedge_[v] == static_cast<int>(v)) {
+                            if(out == NONE && in == NONE) {
+                                kind_[v] = VERTEX_KIND::MANIFOLD;
+                            } else if(out >= 0 && in >= 0 && !positionEdges.has(remap_[out], remap_[v]) && !positionEdges.has(remap_[v], remap_[in])) {
+                                kind_[v] = VERTEX_KIND::BORDER;
+                            }
+                        } else if(wedge_[wedge_[v]] == static_cast<int>(v) && !border[v]) {
+                            // the twin runs the seam the other way round
+                            const auto w = wedge_[v];
+                            if(out >= 0 && in >= 0 && openOut_[w] >= 0 && openIn_[w] >= 0 && !border[w] &&
+                               remap_[out] == remap_[openIn_[w]] && remap_[in] == remap_[openOut_[w]]) {
+                                kind_[v] = VERTEX_KIND::SEAM;
+                            }
+                        }
+                    }
+                }
+
+                // area weighted triangle planes per position
+                void buildQuadrics(const std::vector<std::pair<std::size_t, int>>& borders) {
+                    quadrics_.assign(vc_, Quadric());
+                    for(std::size_t i = 0; i < indices_.size(); i += 3) {
+                        const int v[3] = { indices_[i], indices_[i + 1], indices_[i + 2] };
+                        float n[3];
+                        normal(position(v[0]), position(v[1]), position(v[2]), n);
+                        const auto len = std::sqrt(dot3(n, n));
+                        if(len == 0.f) { continue; }
+                        for(auto&& c : n) { c /= len; }
+                        const Quadric q(n[0], n[1], n[2], -dot3(n, position(v[0])), len * 0.5f);
+                        for(auto&& k : v) { quadrics_[remap_[k]].add(q); }
+                    }
+                    // borders keep their place through a plane along the edge, perpendicular to the triangle
+                    for(auto&& b : borders) {
+                        const auto i = b.first;
+                        const auto v0 = indices_[i + b.second], v1 = indices_[i + (b.second + 1) % 3];
+                        float n[3], edge[3], m[3];
+                        normal(position(indices_[i]), position(indices_[i + 1]), position(indices_[i + 2]), n);
+                        sub3(position(v1), position(v0), edge);
+                        cross3(edge, n, m);
+                        const auto ml = std::sqrt(dot3(m, m));
+                        if(ml == 0.f) { continue; }
+                        for(auto&& c : m) { c /= ml; }
+                        const Quadric bq(m[0], m[1], m[2], -dot3(m, position(v0)), dot3(edge, edge) * BORDER_WEIGHT);
+                        quadrics_[remap_[v0]].add(bq);
+                        quadrics_[remap_[v1]].add(bq);
+                    }
+                }
+
+                // squared difference of the bone weights, summed per bone (padding repeats bones with weight 0)
+                double weightDistance(int v0, int v1) const {
+                    if(mesh_.boneWeights.size() != vc_ * 4 || mesh_.boneIndices.size() != vc_ * 4) { return 0.0; }
+                    const auto bi0 = &mesh_.boneIndices[v0 * 4], bi1 = &mesh_.boneIndices[v1 * 4];
+                    const auto bw0 = &mesh_.boneWeights[v0 * 4], bw1 = &mesh_.boneWeights[v1 * 4];
+                    auto weight = [](const int* bi, const float* bw, int bone) {
+                        double w = 0.0;
+                        for(int j = 0; j < 4; j++) {
+                            if(bi[j] == bone) { w += bw[j]; }
+                        }
+                        return w;
+                    };
+                    double d = 0.0;
+                    for(int k = 0; k < 4; k++) {
+                        if(std::find(bi0, bi0 + k, bi0[k]) == bi0 + k) {
+                            const auto w = weight(bi0, bw0, bi0[k]) - weight(bi1, bw1, bi0[k]);
+                            d += w * w;
+                        }
+                        if(std::find(bi1, bi1 + k, bi1[k]) == bi1 + k && std::find(bi0, bi0 + 4, bi1[k]) == bi0 + 4) {
+                            const auto w = weight(bi1, bw1, bi1[k]);
+                            d += w * w;
+                        }
+                    }
+                    return d;
+                }
+
+                // twin of a seam collapse v0 -> v1, or NONE if v0 may not move onto v1
+                int twin(int v0, int v1) const {
+                    const auto w0 = wedge_[v0];
+                    const auto w1 = openOut_[v0] == v1 ? openIn_[w0] : openIn_[v0] == v1 ? openOut_[w0] : NONE;
+                    return w1 >= 0 && remap_[w1] == remap_[v1] ? w1 : NONE;
+                }
+
+                bool allowed(int v0, int v1) const {
+                    const auto k1 = kind_[v1];
+                    switch(kind_[v0]) {
+                    case VERTEX_KIND::MANIFOLD:
+                        return true;
+                    case VERTEX_KIND::BORDER:
+                        return (k1 == VERTEX_KIND::BORDER || k1 == VERTEX_KIND::LOCKED) && (openOut_[v0] == v1 || openIn_[v0] == v1);
+                    case VERTEX_KIND::SEAM:
+                        return (k1 == VERTEX_KIND::SEAM || k1 == VERTEX_KIND::LOCKED) && twin(v0, v1) != NONE;
+                    default:
+                        return false;
+                    }
+                }
+
+                Collapse candidate(int v0, int v1) const {
+                    const auto d = std::max(0.0, quadrics_[remap_[v0]].error(position(v1)));
+                    return { v0, v1, static_cast<float>(d + weightDistance(v0, v1) * weightScale_), static_cast<float>(d) };
+                }
+
+                /*
+                 * moving v0 onto v1 flips no triangle around v0; removed counts the
+                 * triangles that collapse (those holding both positions)
+                 */
+                bool check(const meshopt::detail::Adjacency& adj, int v0, int v1, std::size_t& removed) const {
+                    const auto p1 = position(v1);
+                    for(auto k = adj.offsets[v0]; k < adj.offsets[v0 + 1]; k++) {
+                        const auto t = adj.triangles[k] * 3;
+                        const int v[3] = { indices_[t], indices_[t + 1], indices_[t + 2] };
+                        if(remap_[v[0]] == remap_[v1] || remap_[v[1]] == remap_[v1] || remap_[v[2]] == remap_[v1]) {
+                            removed++;
+                            continue;
+                        }
+                        const float* p[3] = { position(v[0]), position(v[1]), position(v[2]) };
+                        float before[3], after[3];
+                        normal(p[0], p[1], p[2], before);
+                        for(auto&& q : p) {
+                            if(q == position(v0)) { q = p1; }
+                        }
+                        normal(p[0], p[1], p[2], after);
+                        // turned by more than ~75 degrees: flipped, or folded into a sliver
+                        const auto d = dot3(before, after);
+                        if(d <= 0.f || d * d < MIN_TURN * MIN_TURN * dot3(before, before) * dot3(after, after)) { return false; }
+                        // and still facing like the authored normal where it lands
+                        if(normals_ && dot3(after, normals_ + static_cast<std::size_t>(v1) * 3) <= 0.f) { return false; }
+                    }
+                    return true;
+                }
+
+                // the open edge through v0 now ends at v1
+                void relink(int v0, int v1) {
+                    if(openOut_[v0] == v1) {
+                        const auto u = openIn_[v0];
+                        if(u >= 0) { openOut_[u] = u == v1 ? MANY : v1; openIn_[v1] = u == v1 ? MANY : u; }
+                    } else if(openIn_[v0] == v1) {
+                        const auto x = openOut_[v0];
+                        if(x >= 0) { openOut_[v1] = x == v1 ? MANY : x; openIn_[x] = x == v1 ? MANY : v1; }
+                    }
+                }
+
+                void lockRing(const meshopt::detail::Adjacency& adj, int v, std::vector<uchar>& locked) const {
+                    for(auto k = adj.offsets[v]; k < adj.offsets[v + 1]; k++) {
+                        const auto t = adj.triangles[k] * 3;
+                        for(int e = 0; e < 3; e++) { locked[remap_[indices_[t + e]]] = 1; }
+                    }
+                }
+
+                // one round of independent collapses; false if nothing could collapse
+                bool pass(std::size_t target, double limit) {
+                    const meshopt::detail::Adjacency adj(indices_, vc_);
+                    std::vector<Collapse> candidates;
+                    candidates.reserve(indices_.size());
+                    for(std::size_t i = 0; i < indices_.size(); i += 3) {
+                        for(int e = 0; e < 3; e++) {
+                            const auto a = indices_[i + e], b = indices_[i + (e + 1) % 3];
+                            if(remap_[a] == remap_[b]) { continue; }
+                            // each shared edge shows up from both sides: keep one
+                            if(remap_[a] > remap_[b] && openOut_[a] != b) { continue; }
+                            const auto ab = allowed(a, b), ba = allowed(b, a);
+                            if(!ab && !ba) { continue; }
+                            const auto cab = ab ? candidate(a, b) : Collapse(), cba = ba ? candidate(b, a) : Collapse();
+                            candidates.push_back(!ba || (ab && cab.cost <= cba.cost) ? cab : cba);
+                        }
+                    }
+                    std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+                    std::vector<int> collapse(vc_);
+                    std::iota(collapse.begin(), collapse.end(), 0);
+                    std::vector<uchar> locked(vc_, 0);
+                    auto triangles = indices_.size() / 3;
+                    std::size_t done = 0;
+                    for(auto&& c : candidates) {
+                        if(triangles <= target || c.cost > limit) { break; }
+                        if(locked[remap_[c.v0]] || locked[remap_[c.v1]]) { continue; }
+                        const auto seam = kind_[c.v0] == VERTEX_KIND::SEAM;
+                        const auto s0 = seam ? wedge_[c.v0] : NONE;
+                        const auto s1 = seam ? twin(c.v0, c.v1) : NONE;
+                        if(seam && s1 == NONE) { continue; }
+                        std::size_t removed = 0;
+                        if(!check(adj, c.v0, c.v1, removed)) { continue; }
+                        if(seam && !check(adj, s0, s1, removed)) { continue; }
+
+                        lockRing(adj, c.v0, locked);
+                        collapse[c.v0] = c.v1;
+                        relink(c.v0, c.v1);
+                        if(seam) {
+                            lockRing(adj, s0, locked);
+                            collapse[s0] = s1;
+                            relink(s0, s1);
+                        }
+                        quadrics_[remap_[c.v1]].add(quadrics_[remap_[c.v0]]);
+                        error_ = std::max(error_, std::sqrt(c.distance));
+                        triangles -= std::min(triangles, removed);
+                        done++;
+                    }
+                    if(done == 0) { return false; }
+
+                    // apply, dropping triangles that lost an edge
+                    std::size_t n = 0;
+                    for(std::size_t i = 0; i < indices_.size(); i += 3) {
+                        const int v[3] = { collapse[indices_[i]], collapse[indices_[i + 1]], collapse[indices_[i + 2]] };
+                        if(remap_[v[0]] == remap_[v[1]] || remap_[v[1]] == remap_[v[2]] || remap_[v[0]] == remap_[v[2]]) { continue; }
+                        std::copy(v, v + 3, &indices_[n]);
+                        n += 3;
+                    }
+                    indices_.resize(n);
+                    return true;
+                }
+
+            public:
+                Simplifier(const Mesh& mesh, double extent, float weightScale)
+                    : mesh_(mesh), vc_(mesh.vertices.size() / 3), normals_(mesh.normals.size() == mesh.vertices.size() ? mesh.normals.data() : nullptr), indices_(mesh.indices.begin(), mesh.indices.end()),
+                      weightScale_(static_cast<double>(weightScale) * extent * weightScale * extent), error_(0.f) {
+                    std::vector<std::pair<std::size_t, int>> borders;
+                    buildRemap();
+                    classify(borders);
+                    buildQuadrics(borders);
+                }
+
+                // collapses until at most target triangles remain or every collapse costs more than maxError
+                void run(std::size_t target, float maxError) {
+                    const auto limit = static_cast<double>(maxError) * maxError;
+                    while(indices_.size() / 3 > target && pass(target, limit)) {}
+                }
+
+                const std::vector<int>& indices() const { return indices_; }
+                float error() const { return error_; }
+            };
+
+        } // namespace detail
+
+        /*
+         * renumber vertices coarsest level first: every level then only uses
+         * the vertices below its vertexCount (a prefix to skin or upload).
+         * this replaces the order of meshopt::optimizeVertexFetch: each level
+         * appends its new vertices in order of first use by its own indices,
+         * so every prefix is fetch ordered for the level that ends there and
+         * the full mesh only keeps that order for the vertices of no level.
+         */
+        inline void orderVertices(Mesh& mesh) {
+            const auto vertexCount = mesh.vertices.size() / 3;
+            std::vector<int> remap(vertexCount, -1);
+            int next = 0;
+            auto visit = [&](std::vector<int>& indices) {
+                for(auto&& i : indices) {
+                    if(remap[i] < 0) { remap[i] = next++; }
+                }
+            };
+            for(auto l = mesh.lods.rbegin(); l != mesh.lods.rend(); ++l) { visit(l->indices); }
+            visit(mesh.indices);
+            for(auto&& r : remap) {
+                if(r < 0) { r = next++; }
+            }
+            auto renumber = [&](std::vector<int>& indices) {
+                int top = 0;
+                for(auto&& i : indices) {
+                    i = remap[i];
+                    top = std::max(top, i + 1);
+                }
+                return static_cast<uint>(top);
+            };
+            renumber(mesh.indices);
+            for(auto&& l : mesh.lods) { l.vertexCount = renumber(l.indices); }
+
+            meshopt::detail::permuteStreams(mesh, remap);
+        }
+
+    } // namespace simplify
+
+    /*
+     * replaces mesh.lods by one level per ratio of settings, each simplified
+     * from the previous one and cache optimized, then orders the vertices
+     * coarsest level first (simplify::orderVertices). split vertices (uv
+     * seams) move only along their seam together with their twin, open
+     * borders along the border; bone weight differences add to the cost of a
+     * collapse. levels that cannot get below the previous one within
+     * maxError are dropped. needs float streams (not interleaved).
+     */
+    inline void generateLods(Mesh& mesh, const LodSettings& settings) {
+        mesh.lods.clear();
+        const auto vc = mesh.vertices.size() / 3;
+        const auto tc = mesh.indices.size() / 3;
+        if(vc == 0 || tc == 0 || mesh.indices.size() % 3 != 0 || settings.ratios.empty()) { return; }
+
+        Aabb box;
+        for(std::size_t v = 0; v < vc; v++) { box.extend(&mesh.vertices[v * 3]); }
+        const auto extent = std::max(box.max[0] - box.min[0], std::max(box.max[1] - box.min[1], box.max[2] - box.min[2]));
+        if(!(extent > 0.f)) { return; }
+
+        simplify::detail::Simplifier simplifier(mesh, extent, settings.weightScale);
+        auto previous = tc;
+        for(auto&& ratio : settings.ratios) {
+            const auto target = static_cast<std::size_t>(std::max(0.f, std::min(ratio, 1.f)) * tc);
+            simplifier.run(target, settings.maxError * extent);
+            const auto& indices = simplifier.indices();
+            if(indices.empty() || indices.size() / 3 >= previous) { break; }
+            previous = indices.size() / 3;
+            Lod lod;
+            lod.indices = indices;
+            lod.error = simplifier.error();
+            meshopt::optimizeVertexCache(lod.indices, vc);
+            mesh.lods.push_back(std::move(lod));
+        }
+        if(!mesh.lods.empty()) { simplify::orderVertices(mesh); }
+    }
+
+    // pixels an object space error covers at distance, perspective projection with vertical fov [rad]
+    inline float screenError(float error, float distance, float viewportHeight, float fovY) {
+        return error * viewportHeight / (2.f * std::tan(fovY * 0.5f) * std::max(distance, 1e-6f));
+    }
+
+    /* coarsest level of mesh whose error stays within maxPixels at distance, -1 for the full mesh */
+    template <typename S>
+    inline int selectLod(const BasicMesh<S>& mesh, float distance, float viewportHeight, float fovY, float maxPixels = 1.f) {
+        int level = -1;
+        for(std::size_t i = 0; i < mesh.lods.size(); i++) {
+            if(screenError(mesh.lods[i].error, distance, viewportHeight, fovY) > maxPixels) { break; }
+            level = static_cast<int>(i);
+        }
+        return level;
+    }
+
+}} // namespace rhakt::rechor
+
+#endif
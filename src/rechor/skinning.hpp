@@ -0,0 +1,267 @@
+// rechor project
+// skinning.hpp
+//
+// linear blend skinning on the CPU: Mesh positions/normals deformed by a
+// bone palette (AnimFrame::boneMatrices, 16 floats per bone, FBX row-vector
+// layout: p' = p * M) into caller buffers of 3 floats per vertex.
+
+#ifndef _RHACT_RECHOR_SKINNING_HPP_
+#define _RHACT_RECHOR_SKINNING_HPP_
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX__)
+#define RECHOR_SKINNING_AVX
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RECHOR_SKINNING_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "rechor.hpp"
+#include "keyframe_reducer.hpp"
+#include "../parallel.hpp"
+
+namespace rhakt {
+namespace rechor {
+namespace skinning {
+
+    static const std::size_t INFLUENCES = 4;    // bone indices/weights per vertex
+    static const std::size_t BLOCK = 4096;      // vertices per worker task
+
+    // streams of one skinning job; normals/outNormals may be null
+    struct Job {
+        const float* positions;
+        const float* normals;
+        const int* boneIndices;
+        const float* boneWeights;
+        const float* palette;
+        std::size_t boneCount;
+        float* outPositions;
+        float* outNormals;
+    };
+
+    inline void normalize3(float* n) {
+        const auto l2 = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+        if(l2 > 0.f) {
+            const auto inv = 1.f / std::sqrt(l2);
+            n[0] *= inv; n[1] *= inv; n[2] *= inv;
+        }
+    }
+
+    // vertex v into op (and on, if not null)
+    inline void skinVertex(const Job& job, std::size_t v, float* op, float* on) {
+        float m[16] = {};
+        for(std::size_t k = 0; k < INFLUENCES; k++) {
+            const auto b = static_cast<std::size_t>(job.boneIndices[v * INFLUENCES + k]);
+            const auto w = job.boneWeights[v * INFLUENCES + k];
+            if(b >= job.boneCount) { continue; }
+            const auto bm = job.palette + b * 16;
+            for(int i = 0; i < 16; i++) { m[i] += w * bm[i]; }
+        }
+        const auto p = job.positions + v * 3;
+        for(int j = 0; j < 3; j++) {
+            op[j] = p[0] * m[j] + p[1] * m[4 + j] + p[2] * m[8 + j] + m[12 + j];
+        }
+        if(on) {
+            const auto n = job.normals + v * 3;
+            for(int j = 0; j < 3; j++) {
+                on[j] = n[0] * m[j] + n[1] * m[4 + j] + n[2] * m[8 + j];
+            }
+            normalize3(on);
+        }
+    }
+
+    /* reference kernel, vertices [first, last) */
+    inline void skinScalar(const Job& job, std::size_t first, std::size_t last) {
+        for(auto v = first; v < last; v++) {
+            skinVertex(job, v, job.outPositions + v * 3, job.outNormals ? job.outNormals + v * 3 : nullptr);
+        }
+    }
+
+#ifdef RECHOR_SKINNING_SSE2
+    namespace detail {
+
+        // xyz of v to 3 floats
+        inline void store3(float* out, __m128 v) {
+            _mm_storel_pi(reinterpret_cast<__m64*>(out), v);
+            _mm_store_ss(out + 2, _mm_movehl_ps(v, v));
+        }
+
+        // xyz of v scaled to unit length (w ignored)
+        inline __m128 normalize3(__m128 v) {
+            const auto sq = _mm_mul_ps(v, v);
+            const auto l2 = _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 1, 1, 1))), _mm_movehl_ps(sq, sq)));
+            return l2 > 0.f ? _mm_mul_ps(v, _mm_set1_ps(1.f / std::sqrt(l2))) : v;
+        }
+
+        // out-of-range bones count as weight 0 (on bone 0, so the job needs at least one)
+        inline void influence(const Job& job, std::size_t v, std::size_t k, std::size_t& b, float& w) {
+            b = static_cast<std::size_t>(job.boneIndices[v * INFLUENCES + k]);
+            w = job.boneWeights[v * INFLUENCES + k];
+            if(b >= job.boneCount) { b = 0; w = 0.f; }
+        }
+
+#ifdef RECHOR_SKINNING_AVX
+        // a * b + c (fused with FMA)
+        inline __m256 madd(__m256 a, __m256 b, __m256 c) {
+#ifdef __FMA__
+            return _mm256_fmadd_ps(a, b, c);
+#else
+            return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+        }
+
+        // (lo lo lo lo hi hi hi hi)
+        inline __m256 pair(float lo, float hi) {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(lo)), _mm_set1_ps(hi), 1);
+        }
+#endif
+
+        /*
+         * weighted sum of the bone matrices of vertex v, kept as rows (two per
+         * AVX register, one per SSE register). a point is then
+         * x * row0 + y * row1 + z * row2 + row3.
+         */
+        struct Blend {
+#ifdef RECHOR_SKINNING_AVX
+            __m256 m01;
+            __m256 m23;
+
+            Blend(const Job& job, std::size_t v) : m01(_mm256_setzero_ps()), m23(_mm256_setzero_ps()) {
+                for(std::size_t k = 0; k < INFLUENCES; k++) {
+                    std::size_t b; float w;
+                    influence(job, v, k, b, w);
+                    const auto bm = job.palette + b * 16;
+                    const auto w8 = _mm256_set1_ps(w);
+                    m01 = madd(w8, _mm256_loadu_ps(bm), m01);
+                    m23 = madd(w8, _mm256_loadu_ps(bm + 8), m23);
+                }
+            }
+
+            // (x x x x y y y y) * rows 0-1 + (z z z z w w w w) * rows 2-3, halves summed
+            __m128 apply(const float* p, float w) const {
+                const auto r = madd(pair(p[0], p[1]), m01, _mm256_mul_ps(pair(p[2], w), m23));
+                return _mm_add_ps(_mm256_castps256_ps128(r), _mm256_extractf128_ps(r, 1));
+            }
+#else
+            __m128 r0, r1, r2, r3;
+
+            Blend(const Job& job, std::size_t v) : r0(_mm_setzero_ps()), r1(r0), r2(r0), r3(r0) {
+                for(std::size_t k = 0; k < INFLUENCES; k++) {
+                    std::size_t b; float w;
+                    influence(job, v, k, b, w);
+                    const auto bm = job.palette + b * 16;
+                    const auto w4 = _mm_set1_ps(w);
+                    r0 = _mm_add_ps(r0, _mm_mul_ps(w4, _mm_loadu_ps(bm)));
+                    r1 = _mm_add_ps(r1, _mm_mul_ps(w4, _mm_loadu_ps(bm + 4)));
+                    r2 = _mm_add_ps(r2, _mm_mul_ps(w4, _mm_loadu_ps(bm + 8)));
+                    r3 = _mm_add_ps(r3, _mm_mul_ps(w4, _mm_loadu_ps(bm + 12)));
+                }
+            }
+
+            __m128 apply(const float* p, float w) const {
+                const auto xyz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]), r0), _mm_mul_ps(_mm_set1_ps(p[1]), r1)), _mm_mul_ps(_mm_set1_ps(p[2]), r2));
+                return w == 0.f ? xyz : _mm_add_ps(xyz, r3);
+            }
+#endif
+            __m128 point(const float* p) const { return apply(p, 1.f); }
+            __m128 vector(const float* n) const { return apply(n, 0.f); }
+        };
+
+    } // namespace detail
+
+    /* SIMD kernel, vertices [first, last) */
+    inline void skinSimd(const Job& job, std::size_t first, std::size_t last) {
+        using namespace detail;
+        for(auto v = first; v < last; v++) {
+            const Blend m(job, v);
+            store3(job.outPositions + v * 3, m.point(job.positions + v * 3));
+            if(job.outNormals) {
+                store3(job.outNormals + v * 3, detail::normalize3(m.vector(job.normals + v * 3)));
+            }
+        }
+    }
+
+    /* box grown by the skinned positions of vertices [first, last); nothing is written to the job's outputs */
+    inline void skinBounds(const Job& job, std::size_t first, std::size_t last, Aabb& box) {
+        auto lo = _mm_setr_ps(box.min[0], box.min[1], box.min[2], 0.f);
+        auto hi = _mm_setr_ps(box.max[0], box.max[1], box.max[2], 0.f);
+        for(auto v = first; v < last; v++) {
+            const auto p = detail::Blend(job, v).point(job.positions + v * 3);
+            lo = _mm_min_ps(lo, p);
+            hi = _mm_max_ps(hi, p);
+        }
+        detail::store3(box.min, lo);
+        detail::store3(box.max, hi);
+    }
+#else
+    inline void skinSimd(const Job& job, std::size_t first, std::size_t last) { skinScalar(job, first, last); }
+
+    inline void skinBounds(const Job& job, std::size_t first, std::size_t last, Aabb& box) {
+        for(auto v = first; v < last; v++) {
+            float p[3];
+            skinVertex(job, v, p, nullptr);
+            box.extend(p);
+        }
+    }
+#endif
+
+    // whole job, blocks of vertices over the workers
+    inline void run(const Job& job, std::size_t vertexCount, uint threads) {
+        const auto blocks = (vertexCount + BLOCK - 1) / BLOCK;
+        util::parallel_for(blocks, threads, [&](std::size_t k) {
+            skinSimd(job, k * BLOCK, std::min(vertexCount, (k + 1) * BLOCK));
+        });
+    }
+
+} // namespace skinning
+
+    /*
+     * skins mesh with palette (boneCount matrices) into outPositions and, if
+     * given and the mesh has normals, outNormals (vertices.size() floats each).
+     * normals go through the blended 3x3 and are renormalized (no inverse
+     * transpose: fine for rotation and uniform scale). false if the mesh has
+     * no bone streams for its vertices (or is interleaved) or there is no palette.
+     */
+    template <typename S>
+    inline bool skinMesh(const BasicMesh<S>& mesh, const float* palette, std::size_t boneCount, float* outPositions, float* outNormals = nullptr, uint threads = 1) {
+        const auto vc = mesh.vertices.size() / 3;
+        if(vc == 0 || !palette || boneCount == 0 || mesh.boneIndices.size() != vc * skinning::INFLUENCES || mesh.boneWeights.size() != vc * skinning::INFLUENCES) {
+            return false;
+        }
+        const auto normals = outNormals && mesh.normals.size() == mesh.vertices.size();
+        const skinning::Job job = {
+            mesh.vertices.data(), normals ? mesh.normals.data() : nullptr,
+            mesh.boneIndices.data(), mesh.boneWeights.data(),
+            palette, boneCount,
+            outPositions, normals ? outNormals : nullptr
+        };
+        skinning::run(job, vc, threads);
+        return true;
+    }
+
+    /* same, with the palette of af at frame (clamped; reduced tracks are decoded first) */
+    template <typename S, typename T>
+    inline bool skinMesh(const BasicMesh<S>& mesh, const BasicAnimFrame<T>& af, uint frame, float* outPositions, float* outNormals = nullptr, uint threads = 1) {
+        if(af.reduced()) {
+            if(af.boneKeys.empty() || af.frameCount == 0) { return false; }
+            std::vector<float> palette(af.boneKeys.size() * 16);
+            const auto f = static_cast<float>(std::min(frame, af.frameCount - 1));
+            for(std::size_t b = 0; b < af.boneKeys.size(); b++) {
+                const auto& k = af.boneKeys[b];
+                keyframe::decodeTrack(k.frames.data(), k.keys.data(), k.frames.size(), f, &palette[b * 16]);
+            }
+            return skinMesh(mesh, palette.data(), af.boneKeys.size(), outPositions, outNormals, threads);
+        }
+        if(af.boneMatrices.empty() || af.boneMatrices.stride < 16) { return false; }
+        const auto f = std::min(frame, af.boneMatrices.frameCount - 1);
+        return skinMesh(mesh, af.boneMatrices.frame(f), af.boneMatrices.stride / 16, outPositions, outNormals, threads);
+    }
+
+}} // namespace rhakt::rechor
+
+#endif
@@ -0,0 +1,243 @@
+// rechor project
+// stream_filter.hpp
+//
+// lossless, size preserving filters applied to vertex/index streams
+// of a finished flatbuffer before LZ4, and reverted in place after it.
+
+#ifndef _RHACT_RECHOR_STREAM_FILTER_HPP_
+#define _RHACT_RECHOR_STREAM_FILTER_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RECHOR_FILTER_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "scene_generated.h"
+
+namespace rhakt {
+namespace rechor {
+namespace filter {
+
+    /*-- byte shuffle: n 4-byte elements -> 4 planes of n bytes --*/
+
+#ifdef RECHOR_FILTER_SSE2
+    namespace detail {
+        // perfect shuffle of 64 bytes (rotates the 6 bit byte address left by one)
+        inline void interleave(__m128i* r) {
+            const auto o0 = _mm_unpacklo_epi8(r[0], r[2]);
+            const auto o1 = _mm_unpackhi_epi8(r[0], r[2]);
+            const auto o2 = _mm_unpacklo_epi8(r[1], r[3]);
+            const auto o3 = _mm_unpackhi_epi8(r[1], r[3]);
+            r[0] = o0; r[1] = o1; r[2] = o2; r[3] = o3;
+        }
+    }
+#endif
+
+    inline void shuffle4(const std::uint8_t* src, std::uint8_t* dst, std::size_t n) {
+        std::size_t i = 0;
+#ifdef RECHOR_FILTER_SSE2
+        // 16 elements per step: element*4+byte -> byte*16+element is 4 rotations
+        for(; i + 16 <= n; i += 16) {
+            __m128i r[4];
+            for(int k = 0; k < 4; k++) { r[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + k * 16)); }
+            for(int k = 0; k < 4; k++) { detail::interleave(r); }
+            for(int k = 0; k < 4; k++) { _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + k * n + i), r[k]); }
+        }
+#endif
+        for(; i < n; i++) {
+            for(int k = 0; k < 4; k++) { dst[k * n + i] = src[i * 4 + k]; }
+        }
+    }
+
+    inline void unshuffle4(const std::uint8_t* src, std::uint8_t* dst, std::size_t n) {
+        std::size_t i = 0;
+#ifdef RECHOR_FILTER_SSE2
+        // the inverse rotation is two more steps of the same shuffle
+        for(; i + 16 <= n; i += 16) {
+            __m128i r[4];
+            for(int k = 0; k < 4; k++) { r[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + k * n + i)); }
+            detail::interleave(r);
+            detail::interleave(r);
+            for(int k = 0; k < 4; k++) { _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + k * 16), r[k]); }
+        }
+#endif
+        for(; i < n; i++) {
+            for(int k = 0; k < 4; k++) { dst[i * 4 + k] = src[k * n + i]; }
+        }
+    }
+
+    /*-- delta to the previous value, zigzag so small negative steps stay small --*/
+
+    inline void deltaEncode(std::uint32_t* p, std::size_t n) {
+        std::uint32_t prev = 0;
+        std::size_t i = 0;
+#ifdef RECHOR_FILTER_SSE2
+        auto carry = _mm_setzero_si128();
+        for(; i + 4 <= n; i += 4) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            const auto prevs = _mm_or_si128(_mm_slli_si128(v, 4), _mm_srli_si128(carry, 12));
+            const auto d = _mm_sub_epi32(v, prevs);
+            const auto z = _mm_xor_si128(_mm_slli_epi32(d, 1), _mm_srai_epi32(d, 31));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), z);
+            carry = v;
+        }
+        if(i > 0) { prev = static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(carry, 12))); }
+#endif
+        for(; i < n; i++) {
+            const auto v = p[i];
+            const auto d = v - prev;
+            p[i] = (d << 1) ^ static_cast<std::uint32_t>(static_cast<std::int32_t>(d) >> 31);
+            prev = v;
+        }
+    }
+
+    inline void deltaDecode(std::uint32_t* p, std::size_t n) {
+        std::uint32_t prev = 0;
+        std::size_t i = 0;
+#ifdef RECHOR_FILTER_SSE2
+        auto carry = _mm_setzero_si128();
+        const auto one = _mm_set1_epi32(1);
+        for(; i + 4 <= n; i += 4) {
+            const auto z = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            auto d = _mm_xor_si128(_mm_srli_epi32(z, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z, one)));
+            // prefix sum of 4 lanes, plus the last value of the previous step
+            d = _mm_add_epi32(d, _mm_slli_si128(d, 4));
+            d = _mm_add_epi32(d, _mm_slli_si128(d, 8));
+            d = _mm_add_epi32(d, carry);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + i), d);
+            carry = _mm_shuffle_epi32(d, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+        prev = static_cast<std::uint32_t>(_mm_cvtsi128_si32(carry));
+#endif
+        for(; i < n; i++) {
+            const auto z = p[i];
+            prev += (z >> 1) ^ (0U - (z & 1U));
+            p[i] = prev;
+        }
+    }
+
+    /*
+     * xor with the element `stride` words back (the same component of the previous vertex).
+     * decoding is a serial chain per component, one xor per word.
+     */
+    inline void xorEncode(std::uint32_t* p, std::size_t n, std::size_t stride) {
+        for(auto i = n; i-- > stride; ) { p[i] ^= p[i - stride]; }
+    }
+
+    inline void xorDecode(std::uint32_t* p, std::size_t n, std::size_t stride) {
+        for(auto i = stride; i < n; i++) { p[i] ^= p[i - stride]; }
+    }
+
+    /* applies or reverts the filters on every stream of a mesh/anim/scene root */
+    class StreamFilter {
+    private:
+        std::vector<std::uint8_t> scratch_;
+        bool encode_;
+
+        template <typename T>
+        static std::uint32_t* words(const flatbuffers::Vector<T>* v) {
+            static_assert(sizeof(T) == 4, "4 byte elements only");
+            return reinterpret_cast<std::uint32_t*>(const_cast<T*>(v->data()));
+        }
+
+        void shuffle(std::uint32_t* p, std::size_t n) {
+            const auto bytes = reinterpret_cast<std::uint8_t*>(p);
+            scratch_.resize(n * 4);
+            if(encode_) {
+                shuffle4(bytes, scratch_.data(), n);
+            } else {
+                unshuffle4(bytes, scratch_.data(), n);
+            }
+            std::memcpy(bytes, scratch_.data(), n * 4);
+        }
+
+        // 4-byte values: optional xor with the previous vertex, then byte planes
+        template <typename T>
+        void planes(const flatbuffers::Vector<T>* v, std::size_t xorStride = 0) {
+            if(!v || v->size() == 0) { return; }
+            const auto p = words(v);
+            if(encode_) {
+                if(xorStride) { xorEncode(p, v->size(), xorStride); }
+                shuffle(p, v->size());
+            } else {
+                shuffle(p, v->size());
+                if(xorStride) { xorDecode(p, v->size(), xorStride); }
+            }
+        }
+
+        // ascending-ish integers: zigzag delta, then byte planes
+        template <typename T>
+        void deltas(const flatbuffers::Vector<T>* v) {
+            if(!v || v->size() == 0) { return; }
+            const auto p = words(v);
+            if(encode_) {
+                deltaEncode(p, v->size());
+                shuffle(p, v->size());
+            } else {
+                shuffle(p, v->size());
+                deltaDecode(p, v->size());
+            }
+        }
+
+        // frames back to back: xor with the previous frame, then byte planes
+        void track(const model::Track* t) {
+            if(!t) { return; }
+            planes(t->data(), t->stride());
+        }
+
+        void keys(const model::KeyTrack* k) {
+            if(!k) { return; }
+            planes(k->keys());
+            deltas(k->frames());
+        }
+
+    public:
+        explicit StreamFilter(bool encode) : encode_(encode) {}
+
+        void apply(const model::Mesh* m) {
+            planes(m->vertices(), 3);
+            planes(m->normals());
+            deltas(m->indices());
+            planes(m->colors());
+            planes(m->uvs());
+            planes(m->boneIndices());
+            planes(m->boneWeights());
+            const auto lods = m->lods();
+            for(auto i = 0U; lods && i < lods->size(); i++) { deltas(lods->Get(i)->indices()); }
+            if(const auto ml = m->meshlets()) {
+                planes(ml->ranges());
+                deltas(ml->vertices());
+                planes(ml->bounds());
+            }
+        }
+
+        void apply(const model::Anim* a) {
+            const auto ms = a->meshes();
+            for(auto i = 0U; ms && i < ms->size(); i++) {
+                const auto af = ms->Get(i);
+                track(af->meshTrack());
+                track(af->boneTrack());
+                // legacy per frame tables
+                const auto mm = af->meshMatrices();
+                for(auto f = 0U; mm && f < mm->size(); f++) { planes(mm->Get(f)->data()); }
+                const auto bm = af->boneMatrices();
+                for(auto f = 0U; bm && f < bm->size(); f++) { planes(bm->Get(f)->data()); }
+                keys(af->meshKeys());
+                const auto bk = af->boneKeys();
+                for(auto b = 0U; bk && b < bk->size(); b++) { keys(bk->Get(b)); }
+            }
+        }
+
+        void apply(const model::Scene* s) {
+            for(auto i = 0U; s->meshes() && i < s->meshes()->size(); i++) { apply(s->meshes()->Get(i)); }
+            for(auto i = 0U; s->animes() && i < s->animes()->size(); i++) { apply(s->animes()->Get(i)); }
+        }
+    };
+
+}}} // namespace rhakt::rechor::filter
+
+#endif
@@ -0,0 +1,117 @@
+// rechor project
+// vertex_layout.hpp
+
+#ifndef _RHACT_RECHOR_VERTEX_LAYOUT_HPP_
+#define _RHACT_RECHOR_VERTEX_LAYOUT_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "rechor.hpp"
+
+namespace rhakt {
+namespace rechor {
+
+    inline uint formatSize(VERTEX_FORMAT format) {
+        switch(format) {
+            case VERTEX_FORMAT::FLOAT1: return 4;
+            case VERTEX_FORMAT::FLOAT2: return 8;
+            case VERTEX_FORMAT::FLOAT3: return 12;
+            case VERTEX_FORMAT::FLOAT4: return 16;
+            case VERTEX_FORMAT::UINT8x4: return 4;
+            case VERTEX_FORMAT::UINT16x4: return 8;
+        }
+        return 0;
+    }
+
+    namespace detail {
+
+        struct VertexSource {
+            VERTEX_SEMANTIC semantic;
+            VERTEX_FORMAT format;
+            const void* data;
+            std::size_t size;
+        };
+
+        // non-empty streams of mesh in blob order
+        inline std::vector<VertexSource> vertexSources(const Mesh& mesh) {
+            const auto wide = std::any_of(mesh.boneIndices.begin(), mesh.boneIndices.end(), [](int i) { return i < 0 || i >= 256; });
+            const VertexSource all[] = {
+                { VERTEX_SEMANTIC::POSITION, VERTEX_FORMAT::FLOAT3, mesh.vertices.data(), mesh.vertices.size() },
+                { VERTEX_SEMANTIC::NORMAL, VERTEX_FORMAT::FLOAT3, mesh.normals.data(), mesh.normals.size() },
+                { VERTEX_SEMANTIC::COLOR, VERTEX_FORMAT::FLOAT4, mesh.colors.data(), mesh.colors.size() },
+                { VERTEX_SEMANTIC::TEXCOORD, VERTEX_FORMAT::FLOAT2, mesh.uvs.data(), mesh.uvs.size() },
+                { VERTEX_SEMANTIC::BONE_INDICES, wide ? VERTEX_FORMAT::UINT16x4 : VERTEX_FORMAT::UINT8x4, mesh.boneIndices.data(), mesh.boneIndices.size() },
+                { VERTEX_SEMANTIC::BONE_WEIGHTS, VERTEX_FORMAT::FLOAT4, mesh.boneWeights.data(), mesh.boneWeights.size() },
+            };
+            std::vector<VertexSource> sources;
+            if(mesh.vertices.empty()) { return sources; }
+            for(auto&& s : all) {
+                if(s.size > 0) { sources.push_back(s); }
+            }
+            return sources;
+        }
+
+    } // namespace detail
+
+    /* layout interleaveVertices produces for mesh: floats stay floats, bone indices become 8 (or 16) bit */
+    inline VertexLayout makeVertexLayout(const Mesh& mesh) {
+        VertexLayout layout;
+        for(auto&& s : detail::vertexSources(mesh)) {
+            layout.attributes.push_back({ s.semantic, s.format, static_cast<unsigned short>(layout.stride) });
+            layout.stride += formatSize(s.format);
+        }
+        return layout;
+    }
+
+    /* interleave the streams of mesh into dst (vertex count * layout.stride bytes), one vertex after another */
+    inline void interleaveVertices(const Mesh& mesh, const VertexLayout& layout, uchar* dst) {
+        const auto vc = mesh.vertices.size() / 3;
+        if(vc == 0 || layout.stride == 0) { return; }
+        std::memset(dst, 0, vc * layout.stride);
+        auto a = layout.attributes.begin();
+        for(auto&& s : detail::vertexSources(mesh)) {
+            const auto size = formatSize(s.format);
+            const auto wide = s.format == VERTEX_FORMAT::UINT16x4;
+            for(std::size_t v = 0; v < vc; v++) {
+                const auto p = dst + v * layout.stride + a->offset;
+                if(s.semantic != VERTEX_SEMANTIC::BONE_INDICES) {
+                    std::memcpy(p, static_cast<const float*>(s.data) + v * (size / 4), size);
+                    continue;
+                }
+                const auto bi = static_cast<const int*>(s.data) + v * 4;
+                for(int k = 0; k < 4; k++) {
+                    if(wide) {
+                        const auto i = static_cast<std::uint16_t>(std::min(std::max(bi[k], 0), 0xffff));
+                        std::memcpy(p + k * 2, &i, sizeof(i));
+                    } else {
+                        p[k] = static_cast<uchar>(bi[k]);
+                    }
+                }
+            }
+            ++a;
+        }
+    }
+
+    inline void interleaveVertices(const Mesh& mesh, VertexLayout& layout, std::vector<uchar>& blob) {
+        layout = makeVertexLayout(mesh);
+        blob.resize(mesh.vertices.size() / 3 * layout.stride);
+        interleaveVertices(mesh, layout, blob.data());
+    }
+
+    /* replace the streams of mesh by an interleaved blob */
+    inline void interleaveVertices(Mesh& mesh) {
+        interleaveVertices(static_cast<const Mesh&>(mesh), mesh.layout, mesh.vertexBlob);
+        mesh.vertices.clear();
+        mesh.normals.clear();
+        mesh.colors.clear();
+        mesh.uvs.clear();
+        mesh.boneIndices.clear();
+        mesh.boneWeights.clear();
+    }
+
+}} // namespace rhakt::rechor
+
+#endif
@@ -0,0 +1,140 @@
+// rechor project
+// vertex_welder.hpp
+
+#ifndef _RHACT_RECHOR_VERTEX_WELDER_HPP_
+#define _RHACT_RECHOR_VERTEX_WELDER_HPP_
+
+#include <array>
+#include <tuple>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+#include "rechor.hpp"
+
+namespace rhakt {
+namespace rechor {
+
+    typedef std::array<float, 3> vertex_t;
+    typedef std::array<float, 3> normal_t;
+    typedef std::array<float, 4> color_t;
+    typedef std::array<float, 2> uv_t;
+    typedef std::array<uint,  4> bindex_t;
+    typedef std::array<float, 4> bweight_t;
+    typedef std::tuple<vertex_t, normal_t, color_t, uv_t, bindex_t, bweight_t> element_t;
+
+    /* hash of packed vertex attributes (consistent with element_t operator==) */
+    struct element_hash {
+    private:
+        static void mix(std::uint64_t& h, std::uint32_t v) {
+            h ^= v;
+            h *= 0x100000001b3ULL;
+            h ^= h >> 29;
+        }
+
+        template <std::size_t N>
+        static void mix(std::uint64_t& h, const std::array<float, N>& a) {
+            for(auto&& f : a) {
+                // -0.f == 0.f, so both must hash alike
+                const float v = (f == 0.f) ? 0.f : f;
+                std::uint32_t bits;
+                std::memcpy(&bits, &v, sizeof(bits));
+                mix(h, bits);
+            }
+        }
+
+        template <std::size_t N>
+        static void mix(std::uint64_t& h, const std::array<uint, N>& a) {
+            for(auto&& v : a) { mix(h, static_cast<std::uint32_t>(v)); }
+        }
+
+    public:
+        std::size_t operator()(const element_t& e) const {
+            std::uint64_t h = 0xcbf29ce484222325ULL;
+            mix(h, std::get<0>(e));
+            mix(h, std::get<1>(e));
+            mix(h, std::get<2>(e));
+            mix(h, std::get<3>(e));
+            mix(h, std::get<4>(e));
+            mix(h, std::get<5>(e));
+            return static_cast<std::size_t>(h ^ (h >> 32));
+        }
+    };
+
+    /*
+     * removes duplicate vertices in linear time.
+     * indices are assigned in order of first appearance,
+     * so the result is identical to a linear search over the unique elements.
+     */
+    class VertexWelder : private util::Noncopyable {
+    private:
+        std::unordered_map<element_t, uint, element_hash> map_;
+        uint count_;
+
+    public:
+        explicit VertexWelder(std::size_t reserve = 0) : count_(0) {
+            map_.reserve(reserve);
+        }
+
+        // returns [index, inserted]
+        std::pair<uint, bool> weld(const element_t& e) {
+            auto r = map_.emplace(e, count_);
+            if(r.second) { count_++; }
+            return std::make_pair(r.first->second, r.second);
+        }
+
+        uint size() const { return count_; }
+
+        void clear() {
+            map_.clear();
+            count_ = 0;
+        }
+    };
+
+    /*
+     * indexify a polygon vertex stream (one element per index, like MeshRaw) into a Mesh.
+     * Raw needs indices, vertices, normals, uvs and optionally colors, boneIndices, boneWeights.
+     */
+    template <typename Raw>
+    Mesh weldMesh(const Raw& src) {
+        Mesh dst;
+        VertexWelder welder(src.indices.size());
+
+        dst.vertices.reserve(src.indices.size() * std::tuple_size<vertex_t>::value);
+        dst.normals.reserve(src.indices.size() * std::tuple_size<normal_t>::value);
+        dst.colors.reserve(src.indices.size() * std::tuple_size<color_t>::value);
+        dst.uvs.reserve(src.indices.size() * std::tuple_size<uv_t>::value);
+        dst.indices.reserve(src.indices.size());
+        dst.boneIndices.reserve(src.indices.size() * std::tuple_size<bindex_t>::value);
+        dst.boneWeights.reserve(src.indices.size() * std::tuple_size<bweight_t>::value);
+
+        for (auto i = 0U; i < src.indices.size(); i++) {
+            const auto& ver = src.vertices[i];
+            const auto& nor = src.normals[i];
+            const auto& uv = src.uvs[i];
+            const auto& col = src.colors.empty() ? util::make_array<float>(1.f, 1.f, 1.f, 1.f) : src.colors[i];
+            const auto& bi = src.boneIndices.empty() ? util::make_array<uint>(0U, 0U, 0U, 0U) : src.boneIndices[i];
+            const auto& bw = src.boneWeights.empty() ? util::make_array<float>(0.f, 0.f, 0.f, 0.f) : src.boneWeights[i];
+
+            const auto r = welder.weld(std::make_tuple(ver, nor, col, uv, bi, bw));
+            if(r.second) {
+                /* not found */
+                for(auto&& v : ver) { dst.vertices.push_back(v); }
+                for(auto&& v : nor) { dst.normals.push_back(v); }
+                for(auto&& v : col) { dst.colors.push_back(v); }
+                for(auto&& v : uv) { dst.uvs.push_back(v); }
+                if(src.boneIndices.size()) {
+                    for(auto&& v : bi) { dst.boneIndices.push_back(v); }
+                }
+                if(src.boneWeights.size()) {
+                    for(auto&& v : bw) { dst.boneWeights.push_back(v); }
+                }
+            }
+            dst.indices.push_back(r.first);
+        }
+        return dst;
+    }
+
+}} // namespace rhakt::rechor
+
+#endif
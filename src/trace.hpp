@@ -0,0 +1,185 @@
+// rechor project
+// trace.hpp
+//
+// scoped phase timers written as Chrome trace_event JSON (chrome://tracing, Perfetto).
+// compiled in with RECHOR_ENABLE_TRACE only; otherwise the macros expand to nothing.
+//
+//   RECHOR_TRACE_SCOPE("lz4");           // complete event for the rest of the scope
+//   RECHOR_TRACE_ARG("bytes", size);     // counter on the innermost open scope of this thread
+//   rhakt::trace::write("out.json");     // after the traced work has finished
+
+#ifndef _RHACT_TRACE_HPP_
+#define _RHACT_TRACE_HPP_
+
+#ifdef RECHOR_ENABLE_TRACE
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <cstdint>
+
+namespace rhakt {
+namespace trace {
+
+    static const int MAX_ARGS = 4;
+    static const std::uint64_t OPEN = ~0ULL;
+
+    struct Event {
+        const char* name;           // string literal, never copied
+        std::uint64_t begin;        // ns since the trace epoch
+        std::uint64_t duration;     // OPEN while the scope is alive
+        int argc;
+        const char* keys[MAX_ARGS];
+        std::int64_t values[MAX_ARGS];
+    };
+
+    // events of one thread; only that thread appends
+    struct Buffer {
+        std::uint32_t tid;
+        std::vector<Event> events;
+        std::vector<std::size_t> open;  // indices of scopes not yet closed
+    };
+
+    namespace detail {
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<Buffer>> buffers;   // outlive their threads
+            std::atomic<bool> enabled;
+            const std::chrono::steady_clock::time_point epoch;
+
+            Registry() : enabled(true), epoch(std::chrono::steady_clock::now()) {}
+        };
+
+        inline Registry& registry() {
+            static Registry r;
+            return r;
+        }
+
+        inline Buffer& buffer() {
+            static thread_local Buffer* b = nullptr;
+            if(!b) {
+                auto& r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                r.buffers.emplace_back(new Buffer());
+                b = r.buffers.back().get();
+                b->tid = static_cast<std::uint32_t>(r.buffers.size());
+                b->events.reserve(1024);
+            }
+            return *b;
+        }
+
+        inline std::uint64_t now() {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - registry().epoch).count());
+        }
+
+    } // namespace detail
+
+    inline void enable(bool on) { detail::registry().enabled = on; }
+    inline bool enabled() { return detail::registry().enabled; }
+
+    /* times its own lifetime */
+    class Scope {
+    private:
+        Buffer* buffer_;
+
+    public:
+        explicit Scope(const char* name) : buffer_(nullptr) {
+            if(!enabled()) { return; }
+            buffer_ = &detail::buffer();
+            Event e;
+            e.name = name;
+            e.argc = 0;
+            e.duration = OPEN;
+            buffer_->open.push_back(buffer_->events.size());
+            e.begin = detail::now();
+            buffer_->events.push_back(e);
+        }
+
+        ~Scope() {
+            // nothing to close when clear() ran while the scope was open
+            if(!buffer_ || buffer_->open.empty()) { return; }
+            auto& e = buffer_->events[buffer_->open.back()];
+            e.duration = detail::now() - e.begin;
+            buffer_->open.pop_back();
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // adds a counter to the innermost open scope of the calling thread
+    inline void arg(const char* key, std::int64_t value) {
+        if(!enabled()) { return; }
+        auto& b = detail::buffer();
+        if(b.open.empty()) { return; }
+        auto& e = b.events[b.open.back()];
+        if(e.argc < MAX_ARGS) {
+            e.keys[e.argc] = key;
+            e.values[e.argc++] = value;
+        }
+    }
+
+    /*
+     * drops every recorded event, open scopes included: they record nothing
+     * when they close. call when the traced threads are idle (as write()).
+     */
+    inline void clear() {
+        auto& r = detail::registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for(auto&& b : r.buffers) { b->events.clear(); b->open.clear(); }
+    }
+
+    /*
+     * writes {"traceEvents":[...]} with one complete ("X") event per scope.
+     * call when the traced threads are idle; open scopes are skipped.
+     */
+    inline bool write(const char* filename) {
+        auto& r = detail::registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        std::ofstream ofs(filename);
+        if(!ofs.is_open()) { return false; }
+        ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        auto first = true;
+        for(auto&& b : r.buffers) {
+            for(auto&& e : b->events) {
+                if(e.duration == OPEN) { continue; }
+                ofs << (first ? "" : ",\n");
+                first = false;
+                // names and keys are literals from the source: no escaping needed
+                ofs << "{\"name\":\"" << e.name << "\",\"cat\":\"rechor\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                    << ",\"ts\":" << e.begin / 1000 << '.' << (e.begin % 1000) / 100
+                    << ",\"dur\":" << e.duration / 1000 << '.' << (e.duration % 1000) / 100;
+                if(e.argc > 0) {
+                    ofs << ",\"args\":{";
+                    for(int i = 0; i < e.argc; i++) {
+                        ofs << (i ? "," : "") << '"' << e.keys[i] << "\":" << e.values[i];
+                    }
+                    ofs << '}';
+                }
+                ofs << '}';
+            }
+        }
+        ofs << "\n]}\n";
+        return !ofs.bad();
+    }
+
+}} // namespace rhakt::trace
+
+#define RECHOR_TRACE_CONCAT_(a, b) a##b
+#define RECHOR_TRACE_CONCAT(a, b) RECHOR_TRACE_CONCAT_(a, b)
+#define RECHOR_TRACE_SCOPE(name) ::rhakt::trace::Scope RECHOR_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define RECHOR_TRACE_ARG(key, value) ::rhakt::trace::arg(key, static_cast<std::int64_t>(value))
+
+#else
+
+#define RECHOR_TRACE_SCOPE(name) do {} while(0)
+#define RECHOR_TRACE_ARG(key, value) do {} while(0)
+
+#endif
+
+#endif
@@ -6,6 +6,27 @@
 
 #include <array>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <cstddef>
+#include <cerrno>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
 
 namespace rhakt {
 namespace util {
@@ -63,7 +84,152 @@ namespace util {
     inline bool savefile(const std::string& name, bool binary, const std::string& buf) {
         return savefile(name, binary, buf.c_str(), buf.size());
     }
-    
+
+    /*
+     * binary write without stream buffering: head and body go out in one
+     * write (writev) call, repeated only if the kernel takes less.
+     */
+    inline bool writefile(const std::string& name, const char* head, std::size_t headlen, const char* body = nullptr, std::size_t bodylen = 0) {
+#ifdef _WIN32
+        const auto file = ::CreateFileA(name.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE) { return false; }
+        auto ok = true;
+        const char* parts[2] = { head, body };
+        const std::size_t lens[2] = { headlen, bodylen };
+        for(int i = 0; i < 2 && ok; i++) {
+            auto p = parts[i];
+            auto left = lens[i];
+            while(ok && left > 0) {
+                DWORD written = 0;
+                const auto n = static_cast<DWORD>(std::min<std::size_t>(left, 1U << 30));
+                ok = ::WriteFile(file, p, n, &written, nullptr) != 0 && written > 0;
+                p += written;
+                left -= written;
+            }
+        }
+        ::CloseHandle(file);
+        return ok;
+#else
+        const auto fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) { return false; }
+        struct iovec iov[2] = {
+            { const_cast<char*>(head), headlen },
+            { const_cast<char*>(body), bodylen }
+        };
+        int iovcnt = bodylen > 0 ? 2 : 1;
+        struct iovec* v = iov;
+        auto ok = true;
+        while(iovcnt > 0) {
+            const auto n = ::writev(fd, v, iovcnt);
+            if(n < 0) {
+                if(errno == EINTR) { continue; }
+                ok = false;
+                break;
+            }
+            // partial write: skip what went out
+            auto done = static_cast<std::size_t>(n);
+            while(iovcnt > 0 && done >= v->iov_len) {
+                done -= v->iov_len;
+                v++;
+                iovcnt--;
+            }
+            if(iovcnt > 0) {
+                v->iov_base = static_cast<char*>(v->iov_base) + done;
+                v->iov_len -= done;
+            }
+        }
+        return ::close(fd) == 0 && ok;
+#endif
+    }
+
+    /* read-only view of contiguous elements (not owning) */
+    template <typename T>
+    class array_view {
+    private:
+        const T* data_;
+        std::size_t size_;
+
+    public:
+        typedef T value_type;
+        typedef const T* const_iterator;
+
+        array_view() : data_(nullptr), size_(0) {}
+        array_view(const T* data, std::size_t size) : data_(data), size_(size) {}
+
+        const T* data() const { return data_; }
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const T& operator[](std::size_t i) const { return data_[i]; }
+        const_iterator begin() const { return data_; }
+        const_iterator end() const { return data_ + size_; }
+    };
+
+    /* read-only memory mapped file */
+    class MappedFile : private Noncopyable {
+    private:
+        const char* data_;
+        std::size_t size_;
+#ifdef _WIN32
+        HANDLE file_;
+        HANDLE map_;
+#else
+        int fd_;
+#endif
+
+    public:
+#ifdef _WIN32
+        MappedFile() : data_(nullptr), size_(0), file_(INVALID_HANDLE_VALUE), map_(nullptr) {}
+#else
+        MappedFile() : data_(nullptr), size_(0), fd_(-1) {}
+#endif
+        ~MappedFile() { close(); }
+
+        bool open(const std::string& name) {
+            close();
+#ifdef _WIN32
+            file_ = ::CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if(file_ == INVALID_HANDLE_VALUE) { return false; }
+            LARGE_INTEGER len;
+            if(!::GetFileSizeEx(file_, &len) || len.QuadPart == 0) { close(); return false; }
+            size_ = static_cast<std::size_t>(len.QuadPart);
+            map_ = ::CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if(map_ == nullptr) { close(); return false; }
+            data_ = static_cast<const char*>(::MapViewOfFile(map_, FILE_MAP_READ, 0, 0, 0));
+            if(data_ == nullptr) { close(); return false; }
+#else
+            fd_ = ::open(name.c_str(), O_RDONLY);
+            if(fd_ < 0) { return false; }
+            struct stat st;
+            if(::fstat(fd_, &st) != 0 || st.st_size == 0) { close(); return false; }
+            size_ = static_cast<std::size_t>(st.st_size);
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if(p == MAP_FAILED) { close(); return false; }
+            data_ = static_cast<const char*>(p);
+#endif
+            return true;
+        }
+
+        void close() {
+#ifdef _WIN32
+            if(data_) { ::UnmapViewOfFile(data_); }
+            if(map_) { ::CloseHandle(map_); }
+            if(file_ != INVALID_HANDLE_VALUE) { ::CloseHandle(file_); }
+            map_ = nullptr;
+            file_ = INVALID_HANDLE_VALUE;
+#else
+            if(data_) { ::munmap(const_cast<char*>(data_), size_); }
+            if(fd_ >= 0) { ::close(fd_); }
+            fd_ = -1;
+#endif
+            data_ = nullptr;
+            size_ = 0;
+        }
+
+        bool is_open() const { return data_ != nullptr; }
+        const char* data() const { return data_; }
+        std::size_t size() const { return size_; }
+    };
+
 
 
 }} // namespace rhakt::util
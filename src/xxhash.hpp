@@ -0,0 +1,141 @@
+// rechor project
+// xxhash.hpp
+//
+// XXH64 (https://github.com/Cyan4973/xxHash, BSD 2-Clause)
+
+#ifndef _RHACT_XXHASH_HPP_
+#define _RHACT_XXHASH_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace rhakt {
+namespace util {
+
+    class XXH64 {
+    private:
+        static const std::uint64_t P1 = 11400714785074694791ULL;
+        static const std::uint64_t P2 = 14029467366897019727ULL;
+        static const std::uint64_t P3 = 1609587929392839161ULL;
+        static const std::uint64_t P4 = 9650029242287828579ULL;
+        static const std::uint64_t P5 = 2870177450012600261ULL;
+
+        std::uint64_t v1_, v2_, v3_, v4_;
+        std::uint64_t total_;
+        std::uint64_t seed_;
+        unsigned char mem_[32];
+        std::size_t memsize_;
+
+        static std::uint64_t rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+        static std::uint64_t read64(const unsigned char* p) { std::uint64_t v; std::memcpy(&v, p, 8); return v; }
+        static std::uint32_t read32(const unsigned char* p) { std::uint32_t v; std::memcpy(&v, p, 4); return v; }
+
+        static std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+            acc += input * P2;
+            acc = rotl(acc, 31);
+            return acc * P1;
+        }
+
+        static std::uint64_t merge(std::uint64_t acc, std::uint64_t val) {
+            acc ^= round(0, val);
+            return acc * P1 + P4;
+        }
+
+    public:
+        explicit XXH64(std::uint64_t seed = 0) { reset(seed); }
+
+        void reset(std::uint64_t seed = 0) {
+            seed_ = seed;
+            v1_ = seed + P1 + P2;
+            v2_ = seed + P2;
+            v3_ = seed;
+            v4_ = seed - P1;
+            total_ = 0;
+            memsize_ = 0;
+        }
+
+        void update(const void* data, std::size_t len) {
+            auto p = static_cast<const unsigned char*>(data);
+            const auto end = p + len;
+            total_ += len;
+
+            if(memsize_ + len < 32) {
+                if(len) { std::memcpy(mem_ + memsize_, p, len); }
+                memsize_ += len;
+                return;
+            }
+            if(memsize_) {
+                std::memcpy(mem_ + memsize_, p, 32 - memsize_);
+                v1_ = round(v1_, read64(mem_));
+                v2_ = round(v2_, read64(mem_ + 8));
+                v3_ = round(v3_, read64(mem_ + 16));
+                v4_ = round(v4_, read64(mem_ + 24));
+                p += 32 - memsize_;
+                memsize_ = 0;
+            }
+            while(p + 32 <= end) {
+                v1_ = round(v1_, read64(p));
+                v2_ = round(v2_, read64(p + 8));
+                v3_ = round(v3_, read64(p + 16));
+                v4_ = round(v4_, read64(p + 24));
+                p += 32;
+            }
+            if(p < end) {
+                memsize_ = static_cast<std::size_t>(end - p);
+                std::memcpy(mem_, p, memsize_);
+            }
+        }
+
+        std::uint64_t digest() const {
+            std::uint64_t h;
+            if(total_ >= 32) {
+                h = rotl(v1_, 1) + rotl(v2_, 7) + rotl(v3_, 12) + rotl(v4_, 18);
+                h = merge(h, v1_);
+                h = merge(h, v2_);
+                h = merge(h, v3_);
+                h = merge(h, v4_);
+            } else {
+                h = seed_ + P5;
+            }
+            h += total_;
+
+            auto p = mem_;
+            const auto end = mem_ + memsize_;
+            while(p + 8 <= end) {
+                h ^= round(0, read64(p));
+                h = rotl(h, 27) * P1 + P4;
+                p += 8;
+            }
+            if(p + 4 <= end) {
+                h ^= static_cast<std::uint64_t>(read32(p)) * P1;
+                h = rotl(h, 23) * P2 + P3;
+                p += 4;
+            }
+            while(p < end) {
+                h ^= (*p) * P5;
+                h = rotl(h, 11) * P1;
+                p++;
+            }
+            h ^= h >> 33;
+            h *= P2;
+            h ^= h >> 29;
+            h *= P3;
+            h ^= h >> 32;
+            return h;
+        }
+
+        static std::uint64_t hash(const void* data, std::size_t len, std::uint64_t seed = 0) {
+            XXH64 s(seed);
+            s.update(data, len);
+            return s.digest();
+        }
+    };
+
+    inline std::uint64_t xxh64(const void* data, std::size_t len, std::uint64_t seed = 0) {
+        return XXH64::hash(data, len, seed);
+    }
+
+}} // namespace rhakt::util
+
+#endif